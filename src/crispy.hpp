@@ -73,6 +73,8 @@ struct crispy_t {
   int screenshotmsg {};
   int cleanscreenshot {};
   int demowarp {};
+  int demoseektic {};
+  int demorewind {};
   int fps {};
 
   bool flashinghom {};
@@ -82,6 +84,7 @@ struct crispy_t {
   bool havee1m10 {};
   bool havemap33 {};
   bool havessg {};
+  bool showzone {};
   bool singleplayer {};
   bool stretchsky {};
 
@@ -31,6 +31,7 @@
 
 #include "m_argv.hpp"
 #include "m_fixed.hpp"
+#include "m_profile.hpp"
 
 #include "net_client.hpp"
 #include "net_gui.hpp"
@@ -583,6 +584,8 @@ static void SinglePlayerClear(ticcmd_set_t * set) {
 //
 
 void TryRunTics() {
+  PROFILE_ZONE("TryRunTics");
+
   static int oldentertics;
   int        counts = 0;
 
@@ -19,6 +19,7 @@
 //	and call the startup functions.
 //
 
+#include <algorithm>
 #include <cctype>
 #include <cstdlib>
 #include <cstring>
@@ -50,6 +51,7 @@
 #include "m_controls.hpp"
 #include "m_menu.hpp"
 #include "m_misc.hpp"
+#include "m_profile.hpp"
 #include "p_saveg.hpp"
 
 #include "i_endoom.hpp"
@@ -72,8 +74,11 @@
 #include "p_setup.hpp"
 #include "r_local.hpp"
 #include "statdump.hpp"
+#include "statehash.hpp"
+#include "zonestats.hpp"
 
 #include "d_main.hpp"
+#include "demoverify.hpp"
 #include "lump.hpp"
 #include "memory.hpp"
 
@@ -139,6 +144,8 @@ extern int  showMessages;
 void        R_ExecuteSetViewSize();
 
 bool D_Display() {
+  PROFILE_ZONE("D_Display");
+
   static bool        viewactivestate    = false;
   static bool        menuactivestate    = false;
   static bool        inhelpscreensstate = false;
@@ -458,6 +465,17 @@ void D_RunFrame() {
       // normal update
       I_FinishUpdate(); // page flip or blit buffer
     }
+  } else if (g_i_video_globals->screenvisible && g_doomstat_globals->demoplayback && (crispy->demowarp || crispy->demoseektic)) {
+    // [crispy] nothing is rendered while seeking through a demo,
+    // so keep growing the progress bar over the last frame twice a second
+    static int lastbar;
+
+    nowtime = I_GetTime();
+    if (nowtime - lastbar >= TICRATE / 2) {
+      lastbar = nowtime;
+      HU_DemoProgressBar();
+      I_FinishUpdate();
+    }
   }
 
   // [crispy] post-rendering function pointer to apply config changes
@@ -1370,6 +1388,20 @@ void D_DoomMain() {
     exit(0);
   }
 
+  //!
+  // @arg <file1> <file2>
+  // @category demo
+  //
+  // Compare two files written with -statehash and print the first
+  // tic at which the game state differs.
+  //
+
+  p = M_CheckParmWithArgs("-statehashcompare", 2);
+
+  if (p) {
+    exit(StateHashCompare(myargv[p + 1], myargv[p + 2]) ? 0 : 1);
+  }
+
   //!
   // @category game
   // @vanilla
@@ -1397,6 +1429,16 @@ void D_DoomMain() {
 
   g_doomstat_globals->fastparm = M_CheckParm("-fast");
 
+  //!
+  // @category game
+  //
+  // Trace the monsters' line of sight checks on worker threads
+  // at the start of each tic. Results are identical to the
+  // serial checks. Not used while recording a demo.
+  //
+
+  g_doomstat_globals->parallelai = M_CheckParm("-parallelai");
+
   //!
   // @vanilla
   //
@@ -1506,6 +1548,24 @@ void D_DoomMain() {
   D_BindVariables();
   M_LoadDefaults();
 
+  //!
+  // @arg <listfile>
+  // @category demo
+  //
+  // Verify all demos named in the list file, one per line, each
+  // optionally followed by the file with its expected -statdump
+  // output (default: the demo name with a .txt extension). The demos
+  // are played back headless in parallel worker processes, using the
+  // remaining command line parameters and a copy of the loaded
+  // configuration, and a summary is printed.
+  //
+
+  p = M_CheckParmWithArgs("-demoverify", 1);
+
+  if (p) {
+    exit(DemoVerify(myargv[p + 1]) ? 0 : 1);
+  }
+
   // Save configuration at exit.
   I_AtExit(M_SaveDefaults, true); // [crispy] always save configuration at exit
 
@@ -1976,6 +2036,35 @@ void D_DoomMain() {
     crispy->demowarp = g_doomstat_globals->startmap;
   }
 
+  //!
+  // @arg <n>
+  // @category demo
+  //
+  // If used with -playdemo, fast-forward the demo up to game tic
+  // n (35 tics per second), then continue playback normally.
+  //
+
+  p = M_CheckParmWithArgs("-seektic", 1);
+
+  if (p) {
+    crispy->demoseektic = std::atoi(myargv[p + 1]);
+  }
+
+  //!
+  // @arg <n>
+  // @category demo
+  //
+  // If used with -playdemo, keep an in-memory snapshot of the level
+  // every n seconds of playback, so that the "rewind demo playback"
+  // key can jump back by n seconds.
+  //
+
+  p = M_CheckParmWithArgs("-rewind", 1);
+
+  if (p) {
+    crispy->demorewind = std::max(std::atoi(myargv[p + 1]), 1);
+  }
+
   // Undocumented:
   // Invoked by setup to test the controls.
 
@@ -2068,6 +2157,53 @@ void D_DoomMain() {
     fmt::printf("External statistics registered.\n");
   }
 
+  //!
+  // @arg <file>
+  // @category demo
+  //
+  // Write a 64-bit hash of the game state for every tic played to
+  // the specified file. Run a demo twice and compare the files with
+  // -statehashcompare to find the first tic at which they desync.
+  //
+
+  p = M_CheckParmWithArgs("-statehash", 1);
+
+  if (p) {
+    StateHashOpen(myargv[p + 1]);
+  }
+
+  //!
+  // @arg <file>
+  // @category obscure
+  //
+  // Write zone heap statistics to the specified file at every level
+  // exit: bytes per tag, free memory, fragmentation, purges and
+  // zone grows.
+  //
+
+  p = M_CheckParmWithArgs("-zonestats", 1);
+
+  if (p) {
+    ZoneStatsOpen(myargv[p + 1]);
+  }
+
+#ifdef CRISPY_PROFILER
+  //!
+  // @arg <file>
+  // @category obscure
+  //
+  // Record the profiler zones and write them as a Chrome trace-event
+  // file on exit. Only available in builds configured with
+  // -DENABLE_PROFILER=ON.
+  //
+
+  p = M_CheckParmWithArgs("-profile", 1);
+
+  if (p) {
+    M_ProfileStart(myargv[p + 1]);
+  }
+#endif
+
   //!
   // @arg <x>
   // @category demo
@@ -2097,7 +2233,8 @@ void D_DoomMain() {
       D_DoomLoop(); // never returns
   }
 
-  crispy->demowarp = 0; // [crispy] we don't play a demo, so don't skip maps
+  crispy->demowarp    = 0; // [crispy] we don't play a demo, so don't skip maps
+  crispy->demoseektic = 0;
 
   p = M_CheckParmWithArgs("-timedemo", 1);
   if (p) {
@@ -0,0 +1,286 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Batch demo verification against -statdump output.
+//
+//	Each demo is played back by a separate instance of this program,
+//	started with the same command line plus -cicddemo, -statdump and
+//	the headless options, so that one demo can never affect another.
+//	Worker threads keep as many of these instances running as there
+//	are CPU cores, each with its own copy of the configuration files,
+//	which the instances save on exit.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fmt/format.h>
+#include <fmt/printf.h>
+
+#include "cstring_view.hpp"
+#include "demoverify.hpp"
+#include "i_system.hpp"
+#include "m_argv.hpp"
+#include "m_config.hpp"
+#include "m_misc.hpp"
+
+#ifdef _WIN32
+static const char * const NULL_REDIRECT = " > NUL 2>&1";
+#else
+static const char * const NULL_REDIRECT = " > /dev/null 2>&1";
+#endif
+
+enum class verify_result_t
+{
+  ok,
+  mismatch,
+  failed
+};
+
+struct verify_demo_t {
+  std::string     demo;
+  std::string     expected;
+  std::string     output;
+  verify_result_t result;
+};
+
+// Quote an argument for std::system(). The POSIX shell still expands
+// these characters within double quotes; cmd.exe only needs the quotes
+// themselves escaped.
+
+static std::string Quote(const std::string & arg) {
+#ifdef _WIN32
+  static const char * const special = "\"";
+#else
+  static const char * const special = "\"$`\\";
+#endif
+
+  std::string quoted = "\"";
+
+  for (char c : arg) {
+    if (strchr(special, c) != nullptr) {
+      quoted.push_back('\\');
+    }
+
+    quoted.push_back(c);
+  }
+
+  return quoted + "\"";
+}
+
+// Read a whole text file, dropping carriage returns like
+// "diff --strip-trailing-cr" does.
+
+static bool ReadTextFile(const std::string & name, std::string & text) {
+  FILE * handle = fopen(name.c_str(), "rb");
+
+  if (handle == nullptr) {
+    return false;
+  }
+
+  text.clear();
+
+  int c;
+  while ((c = fgetc(handle)) != EOF) {
+    if (c != '\r') {
+      text.push_back(static_cast<char>(c));
+    }
+  }
+
+  fclose(handle);
+  return true;
+}
+
+static std::vector<verify_demo_t> ReadDemoList(const char * listfile) {
+  std::vector<verify_demo_t> demos;
+  char                       line[512];
+
+  FILE * handle = fopen(listfile, "r");
+
+  if (handle == nullptr) {
+    I_Error("DemoVerify: Couldn't read demo list %s", listfile);
+  }
+
+  // one demo per line, optionally followed by the expected statdump
+  // file, which defaults to the demo name with a .txt extension
+  while (fgets(line, sizeof(line), handle)) {
+    char demo[256], expected[256];
+
+    int items = sscanf(line, "%255s %255s", demo, expected);
+
+    if (items < 1 || demo[0] == '#') {
+      continue;
+    }
+
+    verify_demo_t & entry = demos.emplace_back();
+    entry.demo            = demo;
+    entry.result          = verify_result_t::failed;
+
+    if (items == 2) {
+      entry.expected = expected;
+    } else {
+      std::string base = entry.demo;
+
+      if (M_StringEndsWith(base.c_str(), ".lmp") || M_StringEndsWith(base.c_str(), ".LMP")) {
+        base.resize(base.size() - 4);
+      }
+
+      entry.expected = base + ".txt";
+    }
+  }
+
+  fclose(handle);
+  return demos;
+}
+
+// The command line of this instance without the options that
+// select what to play and where the statistics go.
+
+static std::string WorkerCommandLine() {
+  static const char * const skip_with_arg[] = { "-demoverify", "-statdump", "-playdemo", "-timedemo", "-cicddemo", "-record", "-config", "-extraconfig" };
+  static const char * const skip[]          = { "-nographics", "-nosound", "-nograbmouse" };
+
+  std::string command = Quote(myargv[0]);
+
+  for (int i = 1; i < myargc; i++) {
+    bool skipped = false;
+
+    for (const char * option : skip_with_arg) {
+      if (iequals(myargv[i], option)) {
+        skipped = true;
+        i++;
+        break;
+      }
+    }
+
+    for (const char * option : skip) {
+      if (!skipped && iequals(myargv[i], option)) {
+        skipped = true;
+      }
+    }
+
+    if (!skipped) {
+      command += " " + Quote(myargv[i]);
+    }
+  }
+
+  return command + " -nographics -nosound -nograbmouse";
+}
+
+static void VerifyDemo(const std::string & command, verify_demo_t & demo) {
+  std::string expected, output;
+
+  std::remove(demo.output.c_str());
+
+  const std::string worker = command + " -statdump " + Quote(demo.output) + " -cicddemo " + Quote(demo.demo) + NULL_REDIRECT;
+
+  if (std::system(worker.c_str()) != 0 || !ReadTextFile(demo.output, output)) {
+    demo.result = verify_result_t::failed;
+  } else if (!ReadTextFile(demo.expected, expected) || expected != output) {
+    demo.result = verify_result_t::mismatch;
+  } else {
+    demo.result = verify_result_t::ok;
+  }
+
+  std::remove(demo.output.c_str());
+}
+
+bool DemoVerify(const char * listfile) {
+  std::vector<verify_demo_t> demos   = ReadDemoList(listfile);
+  const std::string          command = WorkerCommandLine();
+  const auto                 start   = std::chrono::steady_clock::now();
+
+  // temporary statdump files, unique per run and per demo
+  const auto runid = std::chrono::duration_cast<std::chrono::milliseconds>(start.time_since_epoch()).count();
+  for (size_t i = 0; i < demos.size(); i++) {
+    char * name     = M_TempFile(fmt::format("demoverify-{}-{}.txt", runid, i).c_str());
+    demos[i].output = name;
+    free(name);
+  }
+
+  const unsigned int numworkers = std::max(std::min(std::thread::hardware_concurrency(), static_cast<unsigned int>(demos.size())), 1U);
+
+  // the configuration the workers load, and save again on exit,
+  // instead of the user's configuration files
+  std::vector<std::string> configs;
+  for (unsigned int i = 0; i < numworkers; i++) {
+    char * main  = M_TempFile(fmt::format("demoverify-{}-{}.cfg", runid, i).c_str());
+    char * extra = M_TempFile(fmt::format("demoverify-{}-{}-extra.cfg", runid, i).c_str());
+    M_SaveDefaultsAlternate(main, extra);
+    configs.push_back(main);
+    configs.push_back(extra);
+    free(main);
+    free(extra);
+  }
+
+  fmt::printf("DemoVerify: Playing back %d demos with %u workers.\n", static_cast<int>(demos.size()), numworkers);
+
+  std::atomic<size_t>      next { 0 };
+  std::vector<std::thread> workers;
+
+  for (unsigned int i = 0; i < numworkers; i++) {
+    const std::string worker_command = command + " -config " + Quote(configs[2 * i]) + " -extraconfig " + Quote(configs[2 * i + 1]);
+
+    workers.emplace_back([&, worker_command]() {
+      size_t index;
+      while ((index = next++) < demos.size()) {
+        VerifyDemo(worker_command, demos[index]);
+      }
+    });
+  }
+
+  for (auto & worker : workers) {
+    worker.join();
+  }
+
+  for (const auto & config : configs) {
+    std::remove(config.c_str());
+  }
+
+  int passed = 0, mismatched = 0, failed = 0;
+
+  for (const auto & demo : demos) {
+    switch (demo.result) {
+    case verify_result_t::ok:
+      passed++;
+      break;
+    case verify_result_t::mismatch:
+      mismatched++;
+      fmt::printf("MISMATCH %s (expected %s)\n", demo.demo, demo.expected);
+      break;
+    case verify_result_t::failed:
+      failed++;
+      fmt::printf("FAILED   %s\n", demo.demo);
+      break;
+    }
+  }
+
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  fmt::printf("DemoVerify: %d of %d demos passed, %d mismatched, %d failed (%.1f seconds).\n",
+              passed,
+              static_cast<int>(demos.size()),
+              mismatched,
+              failed,
+              elapsed.count());
+
+  return passed == static_cast<int>(demos.size());
+}
@@ -0,0 +1,23 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Batch demo verification against -statdump output.
+//
+
+#pragma once
+
+// Play back every demo named in the list file in parallel worker
+// processes and compare their statistics with the expected output.
+// Returns true if all demos matched.
+bool DemoVerify(const char * listfile);
@@ -65,7 +65,8 @@ enum gameaction_t
   ga_completed,
   ga_victory,
   ga_worlddone,
-  ga_screenshot
+  ga_screenshot,
+  ga_rewinddemo
 };
 
 //
@@ -22,6 +22,7 @@ static doomstat_t doomstat_s = {
   .nomonsters              = false,
   .respawnparm             = false,
   .fastparm                = false,
+  .parallelai              = false,
   .devparm                 = false,
   .gamemode                = indetermined,
   .gamemission             = doom,
@@ -52,6 +52,7 @@ struct doomstat_t {
   bool nomonsters;  // checkparm of -nomonsters
   bool respawnparm; // checkparm of -respawn
   bool fastparm;    // checkparm of -fast
+  bool parallelai;  // checkparm of -parallelai
 
   bool devparm; // DEBUG: launched with -devparm
 
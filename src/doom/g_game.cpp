@@ -15,6 +15,7 @@
 // DESCRIPTION:  none
 //
 
+#include <algorithm>
 #include <array>
 #include <cstdlib>
 #include <cstring>
@@ -52,7 +53,9 @@
 #include "hu_stuff.hpp"
 #include "st_stuff.hpp"
 #include "statdump.hpp"
+#include "statehash.hpp"
 #include "wi_stuff.hpp"
+#include "zonestats.hpp"
 
 // Needs access to LFB.
 #include "v_video.hpp"
@@ -72,6 +75,7 @@
 #include "r_sky.hpp"
 
 #include "g_game.hpp"
+#include "g_rewind.hpp"
 #include "lump.hpp"
 #include "memory.hpp"
 #include "v_trans.hpp" // [crispy] colored "always run" message
@@ -196,8 +200,6 @@ static char savename[256]; // [crispy] moved here, made static
 static int  savegameslot;
 static char savedescription[32];
 
-constexpr auto BODYQUESIZE = 32;
-
 mobj_t * bodyque[BODYQUESIZE];
 
 int vanilla_savegame_limit = 1;
@@ -775,6 +777,14 @@ bool G_Responder(event_t * ev) {
     return true;
   }
 
+  // [crispy] rewind demo playback to an earlier snapshot
+  if (g_doomstat_globals->gamestate == GS_LEVEL && ev->type == ev_keydown
+      && ev->data1 == g_m_controls_globals->key_demo_rewind && g_doomstat_globals->demoplayback
+      && !g_doomstat_globals->demorecording && crispy->demorewind && gameaction == ga_nothing) {
+    gameaction = ga_rewinddemo;
+    return true;
+  }
+
   // any other key pops up menu if in demos
   if (gameaction == ga_nothing && !g_doomstat_globals->singledemo && (g_doomstat_globals->demoplayback || g_doomstat_globals->gamestate == GS_DEMOSCREEN)) {
     if (ev->type == ev_keydown || (ev->type == ev_mouse && ev->data1) || (ev->type == ev_joystick && ev->data1)) {
@@ -931,6 +941,9 @@ void G_Ticker() {
     case ga_worlddone:
       G_DoWorldDone();
       break;
+    case ga_rewinddemo:
+      G_DoRewindDemo();
+      break;
     case ga_screenshot:
       // [crispy] redraw view without weapons and HUD
       if (g_doomstat_globals->gamestate == GS_LEVEL && (crispy->cleanscreenshot || crispy->screenshotmsg == 1)) {
@@ -946,6 +959,9 @@ void G_Ticker() {
     }
   }
 
+  // [crispy] keep snapshots for rewinding demo playback
+  G_TakeDemoSnapshot();
+
   // get commands, check consistancy,
   // and build new consistancy check
   int buf = (gametic / ticdup) % BACKUPTICS;
@@ -1048,6 +1064,9 @@ void G_Ticker() {
   switch (g_doomstat_globals->gamestate) {
   case GS_LEVEL:
     P_Ticker();
+    // [crispy] -statehash
+    if (leveltime != oldleveltime)
+      StateHashTicker();
     ST_Ticker();
     AM_Ticker();
     HU_Ticker();
@@ -1377,6 +1396,9 @@ void G_SecretExitLevel() {
 void G_DoCompleted() {
   gameaction = ga_nothing;
 
+  // [crispy] -zonestats
+  ZoneStatsLevelExit();
+
   for (int i = 0; i < MAXPLAYERS; i++)
     if (g_doomstat_globals->playeringame[i])
       G_PlayerFinishLevel(i); // take away cards and stuff
@@ -2053,6 +2075,18 @@ constexpr auto DEMOMARKER = 0x80;
 
 // [crispy] demo progress bar and timer widget
 int defdemotics = 0, deftotaldemotics;
+
+int G_DemoTicsPerGameTic() {
+  int numplayersingame = 0;
+
+  for (bool in_game : g_doomstat_globals->playeringame) {
+    if (in_game) {
+      numplayersingame++;
+    }
+  }
+
+  return std::max(numplayersingame, 1);
+}
 // [crispy] moved here
 static const char * defdemoname;
 
@@ -2103,6 +2137,23 @@ void G_ReadDemoTiccmd(ticcmd_t * cmd) {
   // applies to both recording and playback,
   // because G_WriteDemoTiccmd() calls G_ReadDemoTiccmd() once
   defdemotics++;
+
+  // [crispy] stop demo seek mode once the desired game tic is reached,
+  // unless we are still warping to a later map
+  if (crispy->demoseektic && defdemotics >= crispy->demoseektic * G_DemoTicsPerGameTic() && g_doomstat_globals->demoplayback) {
+    crispy->demoseektic = 0;
+
+    if (!crispy->demowarp) {
+      g_doomstat_globals->nodrawers = false;
+      singletics                    = false;
+
+      // [crispy] start music for the current level,
+      // it was skipped while fast-forwarding
+      if (g_doomstat_globals->gamestate == GS_LEVEL) {
+        S_Start();
+      }
+    }
+  }
 }
 
 // Increase the size of the demo buffer to allow unlimited demos
@@ -2280,7 +2331,8 @@ void G_DeferedPlayDemo(cstring_view name) {
 
   // [crispy] fast-forward demo up to the desired map
   // in demo warp mode or to the end of the demo in continue mode
-  if (crispy->demowarp || g_doomstat_globals->demorecording) {
+  // [crispy] or up to the desired tic in demo seek mode
+  if (crispy->demowarp || crispy->demoseektic || g_doomstat_globals->demorecording) {
     g_doomstat_globals->nodrawers = true;
     singletics                    = true;
   }
@@ -2333,6 +2385,9 @@ void G_DoPlayDemo() {
 
   lumpnum    = W_GetNumForName(defdemoname);
   gameaction = ga_nothing;
+
+  // [crispy] snapshots of the previous demo are useless now
+  G_ClearDemoSnapshots();
   demobuffer = cache_lump_num<uint8_t *>(lumpnum, PU_STATIC);
   demo_p     = demobuffer;
 
@@ -72,5 +72,12 @@ void G_ScreenShot();
 [[maybe_unused]] void G_DrawMouseSpeedBox();
 int                   G_VanillaVersionCode();
 
+// [crispy] defdemotics counts one ticcmd per player in game
+int G_DemoTicsPerGameTic();
+
 extern int vanilla_savegame_limit;
 extern int vanilla_demo_limit;
+
+// [crispy] kept in rewind snapshots
+constexpr auto BODYQUESIZE = 32;
+extern struct mobj_t * bodyque[BODYQUESIZE];
@@ -0,0 +1,223 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	[crispy] In-memory snapshots for rewinding demo playback.
+//	Every few seconds of playback the level is serialized with the
+//	savegame code into a compressed memory buffer. Rewinding restores
+//	the newest snapshot before the desired tic and fast-forwards the
+//	remaining tics in demo seek mode.
+//
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "crispy.hpp"
+#include "d_loop.hpp"
+#include "d_main.hpp"
+#include "doomstat.hpp"
+#include "g_game.hpp"
+#include "g_rewind.hpp"
+#include "i_system.hpp"
+#include "p_extsaveg.hpp"
+#include "p_local.hpp"
+#include "p_saveg.hpp"
+#include "st_stuff.hpp"
+
+constexpr auto MAXDEMOSNAPSHOTS = 128;
+
+struct demosnapshot_t {
+  int                  demotics;      // defdemotics when taken
+  std::ptrdiff_t       demopos;       // offset of demo_p into demobuffer
+  int                  demoleveltics; // gametic - demostarttic
+  int                  prndindex;
+  std::vector<uint8_t> data;          // zero-run compressed savegame
+};
+
+// oldest first
+static std::deque<demosnapshot_t> snapshots;
+
+extern uint8_t * demobuffer;
+extern uint8_t * demo_p;
+extern int       demostarttic;
+extern int       prndindex;
+extern int       savedleveltime;
+
+// Savegames are mostly zero padding and zeroed fields, so a zero byte is
+// stored as a 0 followed by the length of the run of zeros it starts.
+
+static void CompressSnapshot(const std::vector<uint8_t> & in, std::vector<uint8_t> & out) {
+  out.clear();
+  out.reserve(in.size() / 2);
+
+  for (size_t i = 0; i < in.size();) {
+    if (in[i] != 0) {
+      out.push_back(in[i++]);
+      continue;
+    }
+
+    size_t run = 0;
+    while (i < in.size() && in[i] == 0 && run < 255) {
+      i++;
+      run++;
+    }
+    out.push_back(0);
+    out.push_back(static_cast<uint8_t>(run));
+  }
+
+  out.shrink_to_fit();
+}
+
+static void DecompressSnapshot(const std::vector<uint8_t> & in, std::vector<uint8_t> & out) {
+  out.clear();
+
+  for (size_t i = 0; i < in.size(); i++) {
+    if (in[i] != 0) {
+      out.push_back(in[i]);
+    } else if (++i < in.size()) {
+      out.insert(out.end(), in[i], 0);
+    }
+  }
+}
+
+static int DemoTicsPerSecond() {
+  return TICRATE * G_DemoTicsPerGameTic();
+}
+
+void G_ClearDemoSnapshots() {
+  snapshots.clear();
+}
+
+//
+// G_TakeDemoSnapshot
+// Called from G_Ticker before the demo tic is read.
+//
+void G_TakeDemoSnapshot() {
+  static std::vector<uint8_t> buffer;
+  char                        description[SAVESTRINGSIZE] = "demo snapshot";
+
+  if (!crispy->demorewind || !g_doomstat_globals->demoplayback || g_doomstat_globals->demorecording
+      || g_doomstat_globals->gamestate != GS_LEVEL) {
+    return;
+  }
+
+  if (!snapshots.empty() && defdemotics - snapshots.back().demotics < crispy->demorewind * DemoTicsPerSecond()) {
+    return;
+  }
+
+  buffer.clear();
+  P_OpenSaveGameBuffer(&buffer);
+  savegame_error = false;
+
+  P_WriteSaveGameHeader(description);
+  P_ArchivePlayers();
+  P_ArchiveWorld();
+  P_ArchiveSnapshot();
+  P_WriteSaveGameEOF();
+  P_WriteExtendedSaveGameData();
+
+  P_OpenSaveGameBuffer(nullptr);
+
+  if (savegame_error) {
+    return;
+  }
+
+  if (snapshots.size() == MAXDEMOSNAPSHOTS) {
+    snapshots.pop_front();
+  }
+
+  demosnapshot_t & snapshot = snapshots.emplace_back();
+  snapshot.demotics         = defdemotics;
+  snapshot.demopos          = demo_p - demobuffer;
+  snapshot.demoleveltics    = gametic - demostarttic;
+  snapshot.prndindex        = prndindex;
+  CompressSnapshot(buffer, snapshot.data);
+}
+
+//
+// G_DoRewindDemo
+// Go back by one snapshot interval.
+//
+void G_DoRewindDemo() {
+  static std::vector<uint8_t> buffer;
+
+  gameaction = ga_nothing;
+
+  if (snapshots.empty()) {
+    return;
+  }
+
+  const int target = std::max(defdemotics - crispy->demorewind * DemoTicsPerSecond(), 0);
+
+  // newest snapshot at or before the target, or the oldest one we have
+  auto it = std::find_if(snapshots.rbegin(), snapshots.rend(), [target](const demosnapshot_t & s) { return s.demotics <= target; });
+  if (it == snapshots.rend()) {
+    it = std::prev(snapshots.rend());
+  }
+
+  const demosnapshot_t & snapshot      = *it;
+  const int              displayplayer = g_doomstat_globals->displayplayer;
+
+  DecompressSnapshot(snapshot.data, buffer);
+  P_OpenSaveGameBuffer(&buffer);
+  savegame_error = false;
+
+  if (!P_ReadSaveGameHeader()) {
+    I_Error("G_DoRewindDemo: Bad demo snapshot");
+  }
+
+  savedleveltime = leveltime;
+
+  // load a base level
+  G_InitNew(g_doomstat_globals->gameskill, g_doomstat_globals->gameepisode, g_doomstat_globals->gamemap);
+
+  leveltime      = savedleveltime;
+  savedleveltime = 0;
+
+  P_UnArchivePlayers();
+  P_UnArchiveWorld();
+  P_UnArchiveSnapshot();
+  P_RestoreTargets();
+
+  if (!P_ReadSaveGameEOF()) {
+    I_Error("G_DoRewindDemo: Bad demo snapshot");
+  }
+
+  P_ReadExtendedSaveGameData(1);
+  P_OpenSaveGameBuffer(nullptr);
+
+  // G_InitNew() has ended the demo, pick it up where the snapshot was taken
+  g_doomstat_globals->usergame      = false;
+  g_doomstat_globals->demoplayback  = true;
+  g_doomstat_globals->displayplayer = displayplayer;
+  CheckCrispySingleplayer(!g_doomstat_globals->demorecording && !g_doomstat_globals->demoplayback && !g_doomstat_globals->netgame);
+
+  demo_p       = demobuffer + snapshot.demopos;
+  defdemotics  = snapshot.demotics;
+  demostarttic = gametic - snapshot.demoleveltics;
+  prndindex    = snapshot.prndindex;
+
+  // newer snapshots will be taken again while playing on
+  snapshots.erase(it.base(), snapshots.end());
+
+  // fast-forward the remaining tics; -seektic counts game tics
+  if (target > defdemotics) {
+    crispy->demoseektic           = (target + G_DemoTicsPerGameTic() - 1) / G_DemoTicsPerGameTic();
+    g_doomstat_globals->nodrawers = true;
+    singletics                    = true;
+  }
+}
@@ -16,6 +16,7 @@
 //
 
 #include <cctype>
+#include <iterator>
 
 #include "cstring_view.hpp"
 #include "deh_main.hpp"
@@ -77,6 +78,7 @@ static hu_textline_t w_coordx;
 static hu_textline_t w_coordy;
 static hu_textline_t w_coorda;
 static hu_textline_t w_fps;
+static hu_textline_t w_zone[4]; // [crispy] zone heap statistics
 bool                 chat_on;
 static hu_itext_t    w_chat;
 static bool          always_off = false;
@@ -667,6 +669,14 @@ void HU_Start() {
                      hu_font,
                      HU_FONTSTART);
 
+  for (int i = 0; i < static_cast<int>(std::size(w_zone)); i++) {
+    HUlib_initTextLine(&w_zone[i],
+                       HU_TITLEX(),
+                       HU_MSGY + (5 + i) * 8,
+                       hu_font,
+                       HU_FONTSTART);
+  }
+
   const char * s = nullptr;
   switch (logical_gamemission()) {
   case doom:
@@ -851,6 +861,12 @@ void HU_Drawer() {
     HUlib_drawTextLine(&w_fps, false);
   }
 
+  if (crispy->showzone) {
+    for (auto & line : w_zone) {
+      HUlib_drawTextLine(&line, false);
+    }
+  }
+
   if (crispy->crosshair == CROSSHAIR_STATIC)
     HU_DrawCrosshair();
 
@@ -886,6 +902,9 @@ void HU_Erase() {
   HUlib_eraseTextLine(&w_coordy);
   HUlib_eraseTextLine(&w_coorda);
   HUlib_eraseTextLine(&w_fps);
+  for (auto & line : w_zone) {
+    HUlib_eraseTextLine(&line);
+  }
 }
 
 void HU_Ticker() {
@@ -1039,6 +1058,27 @@ void HU_Ticker() {
     while (*s)
       HUlib_addCharToTextLine(&w_fps, *(s++));
   }
+
+  // [crispy] zone heap statistics, in KiB
+  if (crispy->showzone) {
+    const char * gray = crstr[static_cast<int>(cr_t::CR_GRAY)];
+    zone_stats_t stats;
+    char         zonestr[4][64];
+
+    Z_GetStats(&stats);
+
+    M_snprintf(zonestr[0], sizeof(zonestr[0]), "%sZONE %s%d %sFREE %s%d", cr_stat2, gray, static_cast<int>(stats.zone_bytes >> 10), cr_stat2, gray, static_cast<int>(stats.free_bytes >> 10));
+    M_snprintf(zonestr[1], sizeof(zonestr[1]), "%sLARGEST %s%d %sFRAG %s%d%%", cr_stat2, gray, static_cast<int>(stats.largest_free >> 10), cr_stat2, gray, static_cast<int>(100.0 * Z_Fragmentation(stats)));
+    M_snprintf(zonestr[2], sizeof(zonestr[2]), "%sST %s%d %sLV %s%d %sLS %s%d %sPC %s%d", cr_stat2, gray, static_cast<int>(stats.tag_bytes[PU_STATIC] >> 10), cr_stat2, gray, static_cast<int>(stats.tag_bytes[PU_LEVEL] >> 10), cr_stat2, gray, static_cast<int>(stats.tag_bytes[PU_LEVSPEC] >> 10), cr_stat2, gray, static_cast<int>((stats.tag_bytes[PU_PURGELEVEL] + stats.tag_bytes[PU_CACHE]) >> 10));
+    M_snprintf(zonestr[3], sizeof(zonestr[3]), "%sPURGES %s%d %sGROWS %s%d", cr_stat2, gray, stats.purges, cr_stat2, gray, stats.grows);
+
+    for (int i = 0; i < static_cast<int>(std::size(w_zone)); i++) {
+      HUlib_clearTextLine(&w_zone[i]);
+      s = zonestr[i];
+      while (*s)
+        HUlib_addCharToTextLine(&w_zone[i], *(s++));
+    }
+  }
 }
 
 constexpr auto QUEUESIZE = 128;
@@ -49,4 +49,6 @@ void HU_Drawer();
 char HU_dequeueChatChar();
 void HU_Erase();
 
+void HU_DemoProgressBar();
+
 extern const char * chat_macros[10];
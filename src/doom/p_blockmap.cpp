@@ -19,11 +19,15 @@
 //
 
 #include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
 
 #include <fmt/printf.h>
 
 #include "i_system.hpp"
 #include "memory.hpp"
+#include "p_levelcache.hpp"
 #include "p_local.hpp"
 #include "z_zone.hpp"
 
@@ -72,16 +76,26 @@ void map_limits_t::calculate_from_vertexes(vertex_t * vertexes, int count) {
   maxy += 8;
 }
 
-void P_CreateBlockMap() {
-  map_limits_t limits;
-  limits.calculate_from_vertexes(g_r_state_globals->vertexes, g_r_state_globals->numvertexes);
+// [crispy] What the worker thread needs to know of a line, in map
+// units. It doesn't look at the lines themselves: P_LoadNodes_ZDBSP()
+// may move the vertexes while the BLOCKMAP is built.
+struct blockmap_line_t {
+  int x1, y1, x2, y2, dx, dy;
+};
 
-  // Save blockmap parameters
+static struct {
+  std::thread                  thread;
+  std::vector<blockmap_line_t> lines;
+  map_limits_t                 limits;
+  int                          width, height;
+  std::vector<int32_t>         lump;
+} blockmap_build;
 
-  g_p_local_blockmap->bmaporgx   = limits.minx << FRACBITS;
-  g_p_local_blockmap->bmaporgy   = limits.miny << FRACBITS;
-  g_p_local_blockmap->bmapwidth  = ((limits.maxx - limits.minx) >> MAPBTOFRAC) + 1;
-  g_p_local_blockmap->bmapheight = ((limits.maxy - limits.miny) >> MAPBTOFRAC) + 1;
+// Runs on the worker thread, and allocates from the heap only
+
+static void BuildBlockMap() {
+  const map_limits_t & limits    = blockmap_build.limits;
+  const int            bmapwidth = blockmap_build.width;
 
   // Compute blockmap, which is stored as a 2d array of variable-sized lists.
   //
@@ -103,34 +117,35 @@ void P_CreateBlockMap() {
   {
     struct bmap_t {
       int n, nalloc, *list;
-    };                                                                                                       // blocklist structure
-    auto     tot  = static_cast<unsigned int>(g_p_local_blockmap->bmapwidth * g_p_local_blockmap->bmapheight); // size of blockmap
-    bmap_t * bmap = static_cast<bmap_t *>(calloc(sizeof *bmap, tot));                                        // array of blocklists
-    int      x, y, adx, ady, bend;
+    };                                                                                // blocklist structure
+    auto     tot  = static_cast<unsigned int>(bmapwidth * blockmap_build.height);    // size of blockmap
+    bmap_t * bmap = static_cast<bmap_t *>(calloc(sizeof *bmap, tot));                 // array of blocklists
+    int      x, y, adx, ady, bend, count;
 
-    for (int i = 0; i < g_r_state_globals->numlines; i++) {
-      int dx, dy, diff, b;
+    for (int i = 0; i < static_cast<int>(blockmap_build.lines.size()); i++) {
+      const blockmap_line_t & line = blockmap_build.lines[static_cast<size_t>(i)];
+      int                     dx, dy, diff, b;
 
       // starting coordinates
-      x = (g_r_state_globals->lines[i].v1->x >> FRACBITS) - limits.minx;
-      y = (g_r_state_globals->lines[i].v1->y >> FRACBITS) - limits.miny;
+      x = line.x1 - limits.minx;
+      y = line.y1 - limits.miny;
 
       // x-y deltas
-      adx = g_r_state_globals->lines[i].dx >> FRACBITS, dx = adx < 0 ? -1 : 1;
-      ady = g_r_state_globals->lines[i].dy >> FRACBITS, dy = ady < 0 ? -1 : 1;
+      adx = line.dx, dx = adx < 0 ? -1 : 1;
+      ady = line.dy, dy = ady < 0 ? -1 : 1;
 
       // difference in preferring to move across y (>0) instead of x (<0)
       diff = !adx ? 1 : !ady ? -1 :
                                (((x >> MAPBTOFRAC) << MAPBTOFRAC) + (dx > 0 ? MAPBLOCKUNITS - 1 : 0) - x) * (ady = std::abs(ady)) * dx - (((y >> MAPBTOFRAC) << MAPBTOFRAC) + (dy > 0 ? MAPBLOCKUNITS - 1 : 0) - y) * (adx = std::abs(adx)) * dy;
 
       // starting block, and pointer to its blocklist structure
-      b = (y >> MAPBTOFRAC) * g_p_local_blockmap->bmapwidth + (x >> MAPBTOFRAC);
+      b = (y >> MAPBTOFRAC) * bmapwidth + (x >> MAPBTOFRAC);
 
       // ending block
-      bend = (((g_r_state_globals->lines[i].v2->y >> FRACBITS) - limits.miny) >> MAPBTOFRAC) * g_p_local_blockmap->bmapwidth + (((g_r_state_globals->lines[i].v2->x >> FRACBITS) - limits.minx) >> MAPBTOFRAC);
+      bend = ((line.y2 - limits.miny) >> MAPBTOFRAC) * bmapwidth + ((line.x2 - limits.minx) >> MAPBTOFRAC);
 
       // delta for pointer when moving across y
-      dy *= g_p_local_blockmap->bmapwidth;
+      dy *= bmapwidth;
 
       // deltas for diff inside the loop
       adx <<= MAPBTOFRAC;
@@ -168,47 +183,118 @@ void P_CreateBlockMap() {
     // 4 words, unused if this routine is called, are reserved at the start.
 
     {
-      int count = static_cast<int>(tot + 6); // we need at least 1 word per block, plus reserved's
+      count = static_cast<int>(tot + 6); // we need at least 1 word per block, plus reserved's
 
       for (unsigned int i = 0; i < tot; i++)
         if (bmap[i].n)
           count += bmap[i].n + 2; // 1 header word + 1 trailer word + blocklist
 
       // Allocate blockmap lump with computed count
-      g_p_local_blockmap->blockmaplump = zmalloc<decltype(g_p_local_blockmap->blockmaplump)>(sizeof(*g_p_local_blockmap->blockmaplump) * static_cast<unsigned long>(count), PU_LEVEL, 0);
+      blockmap_build.lump.assign(static_cast<size_t>(count), 0);
     }
 
     // Now compress the blockmap.
     {
-      int      ndx = static_cast<int>(tot += 4); // Advance index to start of linedef lists
-      bmap_t * bp  = bmap;                       // Start of uncompressed blockmap
+      int32_t * blockmaplump = blockmap_build.lump.data();
+      int       ndx          = static_cast<int>(tot += 4); // Advance index to start of linedef lists
+      bmap_t *  bp           = bmap;                       // Start of uncompressed blockmap
 
-      g_p_local_blockmap->blockmaplump[ndx++] = 0;  // Store an empty blockmap list at start
-      g_p_local_blockmap->blockmaplump[ndx++] = -1; // (Used for compression)
+      blockmaplump[ndx++] = 0;  // Store an empty blockmap list at start
+      blockmaplump[ndx++] = -1; // (Used for compression)
 
       for (unsigned int i = 4; i < tot; i++, bp++)
         if (bp->n) // Non-empty blocklist
         {
-          g_p_local_blockmap->blockmaplump[g_p_local_blockmap->blockmaplump[i] = ndx++] = 0; // Store index & header
+          blockmaplump[blockmaplump[i] = ndx++] = 0; // Store index & header
           do
-            g_p_local_blockmap->blockmaplump[ndx++] = bp->list[--bp->n]; // Copy linedef list
+            blockmaplump[ndx++] = bp->list[--bp->n]; // Copy linedef list
           while (bp->n);
-          g_p_local_blockmap->blockmaplump[ndx++] = -1; // Store trailer
-          free(bp->list);                              // Free linedef list
-        } else                                         // Empty blocklist: point to reserved empty blocklist
-          g_p_local_blockmap->blockmaplump[i] = static_cast<int32_t>(tot);
+          blockmaplump[ndx++] = -1; // Store trailer
+          free(bp->list);           // Free linedef list
+        } else                      // Empty blocklist: point to reserved empty blocklist
+          blockmaplump[i] = static_cast<int32_t>(tot);
 
       free(bmap); // Free uncompressed blockmap
     }
   }
+}
+
+// In case of an I_Error() before P_FinishCreateBlockMap()
+
+static void JoinBlockMapThread() {
+  if (blockmap_build.thread.joinable()) {
+    blockmap_build.thread.join();
+  }
+}
+
+void P_StartCreateBlockMap() {
+  static bool atexit_added = false;
+
+  // [crispy] built on an earlier visit to the map
+  if (P_LevelCacheBlockMap()) {
+    return;
+  }
+
+  map_limits_t & limits = blockmap_build.limits;
+  limits                = {};
+  limits.calculate_from_vertexes(g_r_state_globals->vertexes, g_r_state_globals->numvertexes);
+
+  // Save blockmap parameters
+
+  g_p_local_blockmap->bmaporgx   = limits.minx << FRACBITS;
+  g_p_local_blockmap->bmaporgy   = limits.miny << FRACBITS;
+  g_p_local_blockmap->bmapwidth  = ((limits.maxx - limits.minx) >> MAPBTOFRAC) + 1;
+  g_p_local_blockmap->bmapheight = ((limits.maxy - limits.miny) >> MAPBTOFRAC) + 1;
+
+  blockmap_build.width  = g_p_local_blockmap->bmapwidth;
+  blockmap_build.height = g_p_local_blockmap->bmapheight;
+
+  blockmap_build.lines.resize(static_cast<size_t>(g_r_state_globals->numlines));
+
+  for (int i = 0; i < g_r_state_globals->numlines; i++) {
+    const line_t * line = &g_r_state_globals->lines[i];
+
+    blockmap_build.lines[static_cast<size_t>(i)] = {
+      line->v1->x >> FRACBITS, line->v1->y >> FRACBITS,
+      line->v2->x >> FRACBITS, line->v2->y >> FRACBITS,
+      line->dx >> FRACBITS, line->dy >> FRACBITS
+    };
+  }
+
+  if (!atexit_added) {
+    I_AtExit(JoinBlockMapThread, true);
+    atexit_added = true;
+  }
+
+  blockmap_build.thread = std::thread(BuildBlockMap);
+
+  fmt::fprintf(stderr, "+BLOCKMAP)\n");
+}
+
+void P_FinishCreateBlockMap() {
+  // not started, the BLOCKMAP came from the level cache
+  if (!blockmap_build.thread.joinable()) {
+    return;
+  }
+
+  blockmap_build.thread.join();
+
+  const int count = static_cast<int>(blockmap_build.lump.size());
+
+  g_p_local_blockmap->blockmaplump = zmalloc<decltype(g_p_local_blockmap->blockmaplump)>(sizeof(*g_p_local_blockmap->blockmaplump) * static_cast<unsigned long>(count), PU_LEVEL, 0);
+  std::memcpy(g_p_local_blockmap->blockmaplump, blockmap_build.lump.data(), blockmap_build.lump.size() * sizeof(int32_t));
+
+  P_LevelCacheStoreBlockMap(count);
 
   // [crispy] copied over from P_LoadBlockMap()
   {
-    const int count                = static_cast<int>(sizeof(*g_p_local_blockmap->blocklinks)) * g_p_local_blockmap->bmapwidth * g_p_local_blockmap->bmapheight;
-    g_p_local_blockmap->blocklinks = zmalloc<decltype(g_p_local_blockmap->blocklinks)>(static_cast<size_t>(count), PU_LEVEL, 0);
-    std::memset(g_p_local_blockmap->blocklinks, 0, static_cast<size_t>(count));
+    const int count_links          = static_cast<int>(sizeof(*g_p_local_blockmap->blocklinks)) * g_p_local_blockmap->bmapwidth * g_p_local_blockmap->bmapheight;
+    g_p_local_blockmap->blocklinks = zmalloc<decltype(g_p_local_blockmap->blocklinks)>(static_cast<size_t>(count_links), PU_LEVEL, 0);
+    std::memset(g_p_local_blockmap->blocklinks, 0, static_cast<size_t>(count_links));
     g_p_local_blockmap->blockmap = g_p_local_blockmap->blockmaplump + 4;
   }
 
-  fmt::fprintf(stderr, "+BLOCKMAP)\n");
+  // the lists are rebuilt for the next map
+  std::vector<blockmap_line_t>().swap(blockmap_build.lines);
+  std::vector<int32_t>().swap(blockmap_build.lump);
 }
@@ -42,4 +42,10 @@ struct p_local_blockmap_t {
   mobj_t ** blocklinks {}; // for thing chains
 };
 
-extern p_local_blockmap_t * const g_p_local_blockmap;
\ No newline at end of file
+extern p_local_blockmap_t * const g_p_local_blockmap;
+
+// [crispy] (re-)create BLOCKMAP; P_StartCreateBlockMap() builds it on a
+// worker thread from the lines, P_FinishCreateBlockMap() puts it in
+// place. Nothing in between may need the BLOCKMAP.
+void P_StartCreateBlockMap();
+void P_FinishCreateBlockMap();
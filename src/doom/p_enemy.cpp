@@ -108,21 +108,15 @@ void P_RecursiveSound(sector_t * sec,
   sec->soundtraversed = soundblocks + 1;
   sec->soundtarget    = soundtarget;
 
-  for (int i = 0; i < sec->linecount; i++) {
-    line_t * check = sec->lines[i];
-    if (!(check->flags & ML_TWOSIDED))
-      continue;
+  for (int i = 0; i < sec->adjcount; i++) {
+    line_t * check = sec->adjacent[i].line;
 
     P_LineOpening(check);
 
     if (g_p_local_globals->openrange <= 0)
       continue; // closed door
 
-    sector_t * other = nullptr;
-    if (g_r_state_globals->sides[check->sidenum[0]].sector == sec)
-      other = g_r_state_globals->sides[check->sidenum[1]].sector;
-    else
-      other = g_r_state_globals->sides[check->sidenum[0]].sector;
+    sector_t * other = sec->adjacent[i].sector;
 
     if (check->flags & ML_SOUNDBLOCK) {
       if (!soundblocks)
@@ -29,12 +29,15 @@
 
 // [crispy] support maps with compressed ZDBSP nodes
 #ifdef HAVE_LIBZ
+#include <thread>
+
 #include <zlib.h>
 #endif
 
 #include "lump.hpp"
 #include "memory.hpp"
 #include "p_extnodes.hpp"
+#include "p_levelcache.hpp"
 
 void       P_SpawnMapThing(mapthing_t * mthing);
 fixed_t    GetOffset(vertex_t * v1, vertex_t * v2);
@@ -179,6 +182,105 @@ void P_LoadNodes_DeePBSP(int lump) {
   W_ReleaseLumpNum(lump);
 }
 
+#ifdef HAVE_LIBZ
+// [crispy] Compressed nodes are inflated on a worker thread, while
+// P_SetupLevel() loads the rest of the map. It only uses the heap.
+static struct {
+  std::thread  thread;
+  uint8_t *    output;
+  size_t       total_in, total_out;
+  const char * error;
+} nodes_inflate;
+
+static void InflateNodes(const uint8_t * lumpdata, size_t len) {
+  size_t    outlen;
+  int       err;
+  z_stream  zstream {};
+  uint8_t * output;
+
+  // first estimate for compression rate:
+  // output buffer size == 2.5 * input size
+  // not I_Realloc(), P_LoadNodes_ZDBSP() raises the errors
+  outlen = len * 5 / 2;
+  output = static_cast<uint8_t *>(malloc(outlen));
+
+  nodes_inflate.error  = nullptr;
+  nodes_inflate.output = output;
+
+  if (output == nullptr) {
+    nodes_inflate.error = "P_LoadNodes: Out of memory for the ZDBSP nodes!";
+    return;
+  }
+
+  // initialize stream state for decompression
+  zstream.next_in   = const_cast<uint8_t *>(lumpdata) + 4;
+  zstream.avail_in  = static_cast<uInt>(len - 4);
+  zstream.next_out  = output;
+  zstream.avail_out = static_cast<uInt>(outlen);
+
+  if (inflateInit(&zstream) != Z_OK) {
+    nodes_inflate.error  = "P_LoadNodes: Error during ZDBSP nodes decompression initialization!";
+    nodes_inflate.output = output;
+    return;
+  }
+
+  // resize if output buffer runs full
+  while ((err = inflate(&zstream, Z_SYNC_FLUSH)) == Z_OK) {
+    const size_t outlen_old = outlen;
+    outlen                  = 2 * outlen_old;
+    auto * resized          = static_cast<uint8_t *>(realloc(output, outlen));
+
+    if (resized == nullptr) {
+      nodes_inflate.error = "P_LoadNodes: Out of memory for the ZDBSP nodes!";
+      break;
+    }
+
+    output            = resized;
+    zstream.next_out  = output + outlen_old;
+    zstream.avail_out = static_cast<uInt>(outlen - outlen_old);
+  }
+
+  if (err != Z_STREAM_END && nodes_inflate.error == nullptr)
+    nodes_inflate.error = "P_LoadNodes: Error during ZDBSP nodes decompression!";
+
+  if (inflateEnd(&zstream) != Z_OK && nodes_inflate.error == nullptr)
+    nodes_inflate.error = "P_LoadNodes: Error during ZDBSP nodes decompression shut-down!";
+
+  nodes_inflate.output    = output;
+  nodes_inflate.total_in  = zstream.total_in;
+  nodes_inflate.total_out = zstream.total_out;
+}
+
+// In case of an I_Error() before P_LoadNodes_ZDBSP()
+
+static void JoinNodesThread() {
+  if (nodes_inflate.thread.joinable()) {
+    nodes_inflate.thread.join();
+  }
+}
+#endif
+
+void P_StartNodes_ZDBSP([[maybe_unused]] int lump) {
+#ifdef HAVE_LIBZ
+  static bool atexit_added = false;
+  size_t      cachedlen;
+
+  if (P_LevelCacheNodes(&cachedlen) != nullptr) {
+    return;
+  }
+
+  // PU_STATIC until P_LoadNodes_ZDBSP() releases it
+  auto * lumpdata = cache_lump_num<uint8_t *>(lump, PU_STATIC);
+
+  if (!atexit_added) {
+    I_AtExit(JoinNodesThread, true);
+    atexit_added = true;
+  }
+
+  nodes_inflate.thread = std::thread(InflateNodes, lumpdata, W_LumpLength(lump));
+#endif
+}
+
 // [crispy] support maps with compressed or uncompressed ZDBSP nodes
 // adapted from prboom-plus/src/p_setup.c:1040-1331
 // heavily modified, condensed and simplyfied
@@ -189,7 +291,7 @@ void P_LoadNodes_DeePBSP(int lump) {
 // - added support for flipped levels
 void P_LoadNodes_ZDBSP(int lump, bool compressed) {
 #ifdef HAVE_LIBZ
-  byte * output;
+  uint8_t * output = nullptr;
 #endif
 
   unsigned int orgVerts, newVerts;
@@ -197,55 +299,39 @@ void P_LoadNodes_ZDBSP(int lump, bool compressed) {
   unsigned int numSegs;
   unsigned int numNodes;
   vertex_t *   newvertarray = nullptr;
+  size_t       cachedlen;
 
-  auto * data = cache_lump_num<uint8_t *>(lump, PU_LEVEL);
+  auto *          lumpdata = cache_lump_num<uint8_t *>(lump, PU_LEVEL);
+  const uint8_t * data     = lumpdata;
+  const uint8_t * cached   = compressed ? P_LevelCacheNodes(&cachedlen) : nullptr;
 
   // 0. Uncompress nodes lump (or simply skip header)
 
-  if (compressed) {
+  if (cached != nullptr) {
+    // [crispy] inflated on an earlier visit to the map
+    data = cached;
+    W_ReleaseLumpNum(lump);
+  } else if (compressed) {
 #ifdef HAVE_LIBZ
-    const int  len = W_LumpLength(lump);
-    int        outlen, err;
-    z_stream * zstream;
-
-    // first estimate for compression rate:
-    // output buffer size == 2.5 * input size
-    outlen = 2.5 * len;
-    output = zmalloc<decltype(output)>(outlen, PU_STATIC, 0);
-
-    // initialize stream state for decompression
-    zstream = malloc(sizeof(*zstream));
-    std::memset(zstream, 0, sizeof(*zstream));
-    zstream->next_in   = data + 4;
-    zstream->avail_in  = len - 4;
-    zstream->next_out  = output;
-    zstream->avail_out = outlen;
-
-    if (inflateInit(zstream) != Z_OK)
-      I_Error("P_LoadNodes: Error during ZDBSP nodes decompression initialization!");
-
-    // resize if output buffer runs full
-    while ((err = inflate(zstream, Z_SYNC_FLUSH)) == Z_OK) {
-      int outlen_old     = outlen;
-      outlen             = 2 * outlen_old;
-      output             = I_Realloc(output, outlen);
-      zstream->next_out  = output + outlen_old;
-      zstream->avail_out = outlen - outlen_old;
-    }
+    // inflate here, if P_StartNodes_ZDBSP() didn't
+    if (nodes_inflate.thread.joinable())
+      nodes_inflate.thread.join();
+    else
+      InflateNodes(lumpdata, W_LumpLength(lump));
 
-    if (err != Z_STREAM_END)
-      I_Error("P_LoadNodes: Error during ZDBSP nodes decompression!");
+    if (nodes_inflate.error != nullptr)
+      I_Error("%s", nodes_inflate.error);
 
-    fmt::fprintf(stderr, "P_LoadNodes: ZDBSP nodes compression ratio %.3f\n", (float)zstream->total_out / zstream->total_in);
+    fmt::fprintf(stderr, "P_LoadNodes: ZDBSP nodes compression ratio %.3f\n", static_cast<float>(nodes_inflate.total_out) / static_cast<float>(nodes_inflate.total_in));
 
-    data = output;
+    output               = nodes_inflate.output;
+    nodes_inflate.output = nullptr;
 
-    if (inflateEnd(zstream) != Z_OK)
-      I_Error("P_LoadNodes: Error during ZDBSP nodes decompression shut-down!");
+    data = output;
+    P_LevelCacheStoreNodes(output, nodes_inflate.total_out);
 
     // release the original data lump
     W_ReleaseLumpNum(lump);
-    free(zstream);
 #else
     I_Error("P_LoadNodes: Compressed ZDBSP nodes are not supported!");
 #endif
@@ -256,10 +342,10 @@ void P_LoadNodes_ZDBSP(int lump, bool compressed) {
 
   // 1. Load new vertices added during node building
 
-  orgVerts = *(reinterpret_cast<unsigned int *>(data));
+  orgVerts = *(reinterpret_cast<const unsigned int *>(data));
   data += sizeof(orgVerts);
 
-  newVerts = *(reinterpret_cast<unsigned int *>(data));
+  newVerts = *(reinterpret_cast<const unsigned int *>(data));
   data += sizeof(newVerts);
 
   if (orgVerts + newVerts == static_cast<unsigned int>(g_r_state_globals->numvertexes)) {
@@ -272,11 +358,11 @@ void P_LoadNodes_ZDBSP(int lump, bool compressed) {
 
   for (unsigned int i = 0; i < newVerts; i++) {
     newvertarray[i + orgVerts].r_x =
-        newvertarray[i + orgVerts].x = static_cast<fixed_t>(*(reinterpret_cast<unsigned int *>(data)));
+        newvertarray[i + orgVerts].x = static_cast<fixed_t>(*(reinterpret_cast<const unsigned int *>(data)));
     data += sizeof(newvertarray[0].x);
 
     newvertarray[i + orgVerts].r_y =
-        newvertarray[i + orgVerts].y = static_cast<fixed_t>(*(reinterpret_cast<unsigned int *>(data)));
+        newvertarray[i + orgVerts].y = static_cast<fixed_t>(*(reinterpret_cast<const unsigned int *>(data)));
     data += sizeof(newvertarray[0].y);
   }
 
@@ -293,7 +379,7 @@ void P_LoadNodes_ZDBSP(int lump, bool compressed) {
 
   // 2. Load subsectors
 
-  numSubs = *(reinterpret_cast<unsigned int *>(data));
+  numSubs = *(reinterpret_cast<const unsigned int *>(data));
   data += sizeof(numSubs);
 
   if (numSubs < 1)
@@ -303,7 +389,7 @@ void P_LoadNodes_ZDBSP(int lump, bool compressed) {
   g_r_state_globals->subsectors    = zmalloc<decltype(g_r_state_globals->subsectors)>(static_cast<unsigned long>(g_r_state_globals->numsubsectors) * sizeof(subsector_t), PU_LEVEL, 0);
 
   for (int i = currSeg = 0; i < g_r_state_globals->numsubsectors; i++) {
-    mapsubsector_zdbsp_t * mseg = reinterpret_cast<mapsubsector_zdbsp_t *>(data) + i;
+    const mapsubsector_zdbsp_t * mseg = reinterpret_cast<const mapsubsector_zdbsp_t *>(data) + i;
 
     g_r_state_globals->subsectors[i].firstline = static_cast<int>(currSeg);
     g_r_state_globals->subsectors[i].numlines  = static_cast<int>(mseg->numsegs);
@@ -314,7 +400,7 @@ void P_LoadNodes_ZDBSP(int lump, bool compressed) {
 
   // 3. Load segs
 
-  numSegs = *(reinterpret_cast<unsigned int *>(data));
+  numSegs = *(reinterpret_cast<const unsigned int *>(data));
   data += sizeof(numSegs);
 
   // The number of stored segs should match the number of segs used by subsectors
@@ -326,11 +412,11 @@ void P_LoadNodes_ZDBSP(int lump, bool compressed) {
   g_r_state_globals->segs    = zmalloc<decltype(g_r_state_globals->segs)>(static_cast<unsigned long>(g_r_state_globals->numsegs) * sizeof(seg_t), PU_LEVEL, 0);
 
   for (int i = 0; i < g_r_state_globals->numsegs; i++) {
-    line_t *         ldef;
-    unsigned int     linedef_local;
-    unsigned char    side;
-    seg_t *          li = g_r_state_globals->segs + i;
-    mapseg_zdbsp_t * ml = reinterpret_cast<mapseg_zdbsp_t *>(data) + i;
+    line_t *               ldef;
+    unsigned int           linedef_local;
+    unsigned char          side;
+    seg_t *                li = g_r_state_globals->segs + i;
+    const mapseg_zdbsp_t * ml = reinterpret_cast<const mapseg_zdbsp_t *>(data) + i;
 
     li->v1 = &g_r_state_globals->vertexes[ml->v1];
     li->v2 = &g_r_state_globals->vertexes[ml->v2];
@@ -371,15 +457,15 @@ void P_LoadNodes_ZDBSP(int lump, bool compressed) {
 
   // 4. Load nodes
 
-  numNodes = *(reinterpret_cast<unsigned int *>(data));
+  numNodes = *(reinterpret_cast<const unsigned int *>(data));
   data += sizeof(numNodes);
 
   g_r_state_globals->numnodes = static_cast<int>(numNodes);
   g_r_state_globals->nodes    = zmalloc<decltype(g_r_state_globals->nodes)>(static_cast<unsigned long>(g_r_state_globals->numnodes) * sizeof(node_t), PU_LEVEL, 0);
 
   for (int i = 0; i < g_r_state_globals->numnodes; i++) {
-    node_t *          no = g_r_state_globals->nodes + i;
-    mapnode_zdbsp_t * mn = reinterpret_cast<mapnode_zdbsp_t *>(data) + i;
+    node_t *                no = g_r_state_globals->nodes + i;
+    const mapnode_zdbsp_t * mn = reinterpret_cast<const mapnode_zdbsp_t *>(data) + i;
 
     no->x  = SHORT(mn->x) << FRACBITS;
     no->y  = SHORT(mn->y) << FRACBITS;
@@ -394,12 +480,13 @@ void P_LoadNodes_ZDBSP(int lump, bool compressed) {
     }
   }
 
+  if (compressed) {
 #ifdef HAVE_LIBZ
-  if (compressed)
-    Z_Free(output);
-  else
+    free(output);
 #endif
+  } else {
     W_ReleaseLumpNum(lump);
+  }
 }
 
 // [crispy] allow loading of Hexen-format maps
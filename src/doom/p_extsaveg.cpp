@@ -40,7 +40,7 @@ static char *line, *string;
 
 static void P_WritePackageTarname(cstring_view key) {
   M_snprintf(line, MAX_LINE_LEN, "%s %s\n", key.c_str(), PACKAGE_VERSION);
-  fputs(line, save_stream);
+  P_WriteSaveGameString(line);
 }
 
 // maplumpinfo->wad_file->basename
@@ -49,7 +49,7 @@ char * savewadfilename = nullptr;
 
 static void P_WriteWadFileName(cstring_view key) {
   M_snprintf(line, MAX_LINE_LEN, "%s %s\n", key.c_str(), W_WadNameForLump(maplumpinfo));
-  fputs(line, save_stream);
+  P_WriteSaveGameString(line);
 }
 
 static void P_ReadWadFileName(cstring_view key) {
@@ -70,7 +70,7 @@ static void P_ReadWadFileName(cstring_view key) {
 static void P_WriteExtraKills(cstring_view key) {
   if (g_doomstat_globals->extrakills) {
     M_snprintf(line, MAX_LINE_LEN, "%s %d\n", key.c_str(), g_doomstat_globals->extrakills);
-    fputs(line, save_stream);
+    P_WriteSaveGameString(line);
   }
 }
 
@@ -87,7 +87,7 @@ static void P_ReadExtraKills(cstring_view key) {
 static void P_WriteTotalLevelTimes(cstring_view key) {
   if (g_doomstat_globals->totalleveltimes) {
     M_snprintf(line, MAX_LINE_LEN, "%s %d\n", key.c_str(), g_doomstat_globals->totalleveltimes);
-    fputs(line, save_stream);
+    P_WriteSaveGameString(line);
   }
 }
 
@@ -101,16 +101,18 @@ static void P_ReadTotalLevelTimes(cstring_view key) {
 
 // T_FireFlicker()
 
-extern void T_FireFlicker(fireflicker_t * flick);
-
 static void P_WriteFireFlicker(cstring_view key) {
+  // [crispy] snapshots keep fire flickers in thinker order
+  if (P_SaveGameInMemory())
+    return;
+
   action_hook needle = T_FireFlicker;
   for (thinker_t * th = g_p_local_globals->thinkercap.next; th != &g_p_local_globals->thinkercap; th = th->next) {
     if (th->function == needle) {
       auto * flick = reinterpret_cast<fireflicker_t *>(th);
 
       M_snprintf(line, MAX_LINE_LEN, "%s %d %d %d %d\n", key.c_str(), static_cast<int>(flick->sector - g_r_state_globals->sectors), static_cast<int>(flick->count), static_cast<int>(flick->maxlight), static_cast<int>(flick->minlight));
-      fputs(line, save_stream);
+      P_WriteSaveGameString(line);
     }
   }
 }
@@ -143,7 +145,7 @@ static void P_WriteSoundTarget(cstring_view key) {
   for (i = 0, sector = g_r_state_globals->sectors; i < g_r_state_globals->numsectors; i++, sector++) {
     if (sector->soundtarget) {
       M_snprintf(line, MAX_LINE_LEN, "%s %d %d\n", key.c_str(), i, P_ThinkerToIndex(reinterpret_cast<thinker_t *>(sector->soundtarget)));
-      fputs(line, save_stream);
+      P_WriteSaveGameString(line);
     }
   }
 }
@@ -167,7 +169,7 @@ static void P_WriteOldSpecial(cstring_view key) {
   for (i = 0, sector = g_r_state_globals->sectors; i < g_r_state_globals->numsectors; i++, sector++) {
     if (sector->oldspecial) {
       M_snprintf(line, MAX_LINE_LEN, "%s %d %d\n", key.c_str(), i, sector->oldspecial);
-      fputs(line, save_stream);
+      P_WriteSaveGameString(line);
     }
   }
 }
@@ -193,7 +195,7 @@ static void P_WriteButton(cstring_view key) {
 
     if (button->btimer) {
       M_snprintf(line, MAX_LINE_LEN, "%s %d %d %d %d\n", key.c_str(), static_cast<int>(button->line - g_r_state_globals->lines), static_cast<int>(button->where), static_cast<int>(button->btexture), static_cast<int>(button->btimer));
-      fputs(line, save_stream);
+      P_WriteSaveGameString(line);
     }
   }
 }
@@ -220,7 +222,7 @@ static void P_WriteBrainTarget(cstring_view key) {
 
       if (mo->state == &states[S_BRAINEYE1]) {
         M_snprintf(line, MAX_LINE_LEN, "%s %d %d\n", key.c_str(), numbraintargets, braintargeton);
-        fputs(line, save_stream);
+        P_WriteSaveGameString(line);
 
         // [crispy] return after the first brain spitter is found
         return;
@@ -251,7 +253,7 @@ static void P_WriteMarkPoints(cstring_view key) {
 
   if (p[0] != -1) {
     M_snprintf(line, MAX_LINE_LEN, "%s %d %ld %ld %ld %ld %ld %ld %ld %ld %ld %ld %ld %ld %ld %ld %ld %ld %ld %ld %ld %ld\n", key.c_str(), n, p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7], p[8], p[9], p[10], p[11], p[12], p[13], p[14], p[15], p[16], p[17], p[18], p[19]);
-    fputs(line, save_stream);
+    P_WriteSaveGameString(line);
   }
 }
 
@@ -272,7 +274,7 @@ static void P_WritePlayersLookdir(cstring_view key) {
   for (int i = 0; i < MAXPLAYERS; i++) {
     if (g_doomstat_globals->playeringame[i] && g_doomstat_globals->players[i].lookdir) {
       M_snprintf(line, MAX_LINE_LEN, "%s %d %d\n", key.c_str(), i, g_doomstat_globals->players[i].lookdir);
-      fputs(line, save_stream);
+      P_WriteSaveGameString(line);
     }
   }
 }
@@ -295,7 +297,7 @@ static void P_WriteMusInfo(cstring_view key) {
     strncpy(orig, lumpinfo[musinfo.items[0]]->name, 8);
 
     M_snprintf(line, MAX_LINE_LEN, "%s %s %s\n", key.c_str(), lump, orig);
-    fputs(line, save_stream);
+    P_WriteSaveGameString(line);
   }
 }
 
@@ -354,7 +356,7 @@ void P_WriteExtendedSaveGameData() {
 }
 
 static void P_ReadKeyValuePairs(int pass) {
-  while (fgets(line, MAX_LINE_LEN, save_stream)) {
+  while (P_ReadSaveGameString(line, MAX_LINE_LEN)) {
     if (sscanf(line, "%s", string) == 1) {
       for (size_t i = 1; i < std::size(extsavegdata); i++) {
         if (extsavegdata[i].extsavegreadfn && extsavegdata[i].pass == pass && !strncmp(string, extsavegdata[i].key, MAX_STRING_LEN)) {
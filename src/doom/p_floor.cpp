@@ -54,6 +54,8 @@ result_e
   sector->oldceilingheight = sector->ceilingheight;
   sector->oldgametic       = gametic;
 
+  sector->heightgen++;
+
   switch (floorOrCeiling) {
   case 0:
     // FLOOR
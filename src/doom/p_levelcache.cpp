@@ -0,0 +1,384 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	[crispy] On-disk cache of level data derived at setup time
+//
+//	Entries are named after the SHA1 hash of the map lumps and live in
+//	<configdir>/levelcache/. An entry is a header, a section table and
+//	the sections, each 8-byte aligned and in native byte order, so it
+//	is used in place when W_OpenFile() can map it. Data that ends up in
+//	the zone, like the BLOCKMAP, is copied from there.
+//
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <fmt/printf.h>
+
+#include "i_system.hpp"
+#include "lump.hpp"
+#include "m_argv.hpp"
+#include "m_config.hpp"
+#include "m_misc.hpp"
+#include "memory.hpp"
+#include "p_blockmap.hpp"
+#include "p_local.hpp"
+#include "r_state.hpp"
+#include "sha1.hpp"
+#include "w_file.hpp"
+#include "w_wad.hpp"
+#include "z_zone.hpp"
+
+#include "p_levelcache.hpp"
+
+// Bump when the layout or the contents of a section change
+constexpr uint32_t LEVELCACHE_VERSION = 1;
+
+enum levelcache_section_e : uint32_t
+{
+  LCS_BLOCKMAP,    // int32_t blockmaplump[count], header words filled in
+  LCS_NODES,       // inflated ZDBSP nodes, count bytes
+  LCS_SLIMETRAILS, // fixed_t r_x, r_y for count vertexes
+  NUMLCSECTIONS
+};
+
+struct levelcache_header_t {
+  char          magic[4];
+  uint32_t      version;
+  sha1_digest_t key;
+  uint32_t      numsections;
+};
+
+struct levelcache_section_t {
+  uint32_t type;
+  uint32_t count;
+  uint32_t offset;
+  uint32_t length;
+};
+
+static const char levelcache_magic[4] = { 'L', 'V', 'L', 'C' };
+
+static struct {
+  bool            active;
+  sha1_digest_t   key;
+  char *          path;
+  wad_file_t *    file;
+  const uint8_t * image;  // the entry, mapped or read
+  uint8_t *       buffer; // read, if not mapped
+
+  const levelcache_section_t * sections[NUMLCSECTIONS];
+
+  // to write on P_LevelCacheClose(), if the entry was missing
+  std::vector<levelcache_section_t> stored;
+  std::vector<uint8_t>              storeddata;
+} levelcache;
+
+static const char * LevelCacheDir() {
+  static char * dir = nullptr;
+
+  if (dir == nullptr) {
+    char * topdir = M_StringJoin(configdir, "levelcache");
+    M_MakeDirectory(topdir);
+
+    dir = M_StringJoin(topdir, DIR_SEPARATOR_S);
+    free(topdir);
+  }
+
+  return dir;
+}
+
+static void LevelCacheKey(int lumpnum, sha1_digest_t key) {
+  sha1_context_t context;
+
+  SHA1_Init(&context);
+
+  // The lumps P_SetupLevel() loads the map from
+  const int last = std::min(lumpnum + static_cast<int>(ML_BLOCKMAP), static_cast<int>(numlumps) - 1);
+
+  for (int i = lumpnum + ML_THINGS; i <= last; ++i) {
+    const size_t length = W_LumpLength(i);
+
+    SHA1_UpdateInt32(&context, static_cast<unsigned int>(length));
+
+    if (length > 0) {
+      SHA1_Update(&context, cache_lump_num<uint8_t *>(i, PU_STATIC), length);
+      W_ReleaseLumpNum(i);
+    }
+  }
+
+  SHA1_Final(key, &context);
+}
+
+// Check the entry, and find its sections
+
+static bool LevelCacheValid(size_t length) {
+  const auto * header = reinterpret_cast<const levelcache_header_t *>(levelcache.image);
+
+  if (length < sizeof(*header)
+      || std::memcmp(header->magic, levelcache_magic, sizeof(header->magic)) != 0
+      || header->version != LEVELCACHE_VERSION
+      || std::memcmp(header->key, levelcache.key, sizeof(header->key)) != 0
+      || sizeof(*header) + header->numsections * sizeof(levelcache_section_t) > length) {
+    return false;
+  }
+
+  const auto * section = reinterpret_cast<const levelcache_section_t *>(header + 1);
+
+  for (uint32_t i = 0; i < header->numsections; ++i, ++section) {
+    if (static_cast<size_t>(section->offset) + section->length > length || section->offset % 8 != 0) {
+      return false;
+    }
+
+    if (section->type < NUMLCSECTIONS) {
+      levelcache.sections[section->type] = section;
+    }
+  }
+
+  return true;
+}
+
+void P_LevelCacheOpen(int lumpnum, bool needed) {
+  //!
+  // @category obscure
+  //
+  // Don't keep derived level data, like rebuilt BLOCKMAPs and
+  // inflated nodes, in a cache directory between runs.
+  //
+
+  if (!needed || M_ParmExists("-nolevelcache")) {
+    return;
+  }
+
+  levelcache.active = true;
+  LevelCacheKey(lumpnum, levelcache.key);
+
+  char name[sizeof(sha1_digest_t) * 2 + 5];
+  for (size_t i = 0; i < sizeof(sha1_digest_t); ++i) {
+    M_snprintf(name + i * 2, 3, "%02x", levelcache.key[i]);
+  }
+  M_StringConcat(name, ".lvl", sizeof(name));
+
+  levelcache.path = M_StringJoin(LevelCacheDir(), name);
+
+  if (!M_FileExists(levelcache.path)) {
+    return;
+  }
+
+  levelcache.file = W_OpenFile(levelcache.path);
+
+  if (levelcache.file == nullptr) {
+    return;
+  }
+
+  const size_t length = levelcache.file->length;
+
+  if (levelcache.file->mapped != nullptr) {
+    levelcache.image = levelcache.file->mapped;
+  } else {
+    levelcache.buffer = static_cast<uint8_t *>(I_Realloc(nullptr, std::max(length, static_cast<size_t>(1))));
+
+    if (W_Read(levelcache.file, 0, levelcache.buffer, length) == length) {
+      levelcache.image = levelcache.buffer;
+    }
+  }
+
+  if (levelcache.image != nullptr && !LevelCacheValid(length)) {
+    fmt::fprintf(stderr, "P_LevelCacheOpen: ignoring invalid %s\n", levelcache.path);
+    std::fill(std::begin(levelcache.sections), std::end(levelcache.sections), nullptr);
+    levelcache.image = nullptr;
+  }
+}
+
+static void LevelCacheWrite() {
+  levelcache_header_t header {};
+
+  std::memcpy(header.magic, levelcache_magic, sizeof(header.magic));
+  header.version     = LEVELCACHE_VERSION;
+  header.numsections = static_cast<uint32_t>(levelcache.stored.size());
+  std::memcpy(header.key, levelcache.key, sizeof(header.key));
+
+  // header and section table are a multiple of 8 bytes
+  const size_t base = sizeof(header) + levelcache.stored.size() * sizeof(levelcache_section_t);
+
+  for (auto & section : levelcache.stored) {
+    section.offset += static_cast<uint32_t>(base);
+  }
+
+  std::vector<uint8_t> image(base);
+  std::memcpy(image.data(), &header, sizeof(header));
+  std::memcpy(image.data() + sizeof(header), levelcache.stored.data(), levelcache.stored.size() * sizeof(levelcache_section_t));
+  image.insert(image.end(), levelcache.storeddata.begin(), levelcache.storeddata.end());
+
+  // Write to a temporary file first, so that an entry is complete
+  // or missing, never cut short
+  char * temp = M_StringJoin(levelcache.path, ".tmp");
+
+  if (M_WriteFile(temp, image.data(), static_cast<int>(image.size()))) {
+    remove(levelcache.path);
+    rename(temp, levelcache.path);
+  } else {
+    fmt::fprintf(stderr, "P_LevelCacheClose: unable to write %s\n", levelcache.path);
+    remove(temp);
+  }
+
+  free(temp);
+}
+
+void P_LevelCacheClose() {
+  const bool write = levelcache.active && levelcache.image == nullptr && !levelcache.stored.empty();
+
+  // an invalid entry is replaced, close it first
+  if (levelcache.file != nullptr) {
+    W_CloseFile(levelcache.file);
+  }
+
+  if (write) {
+    LevelCacheWrite();
+  }
+
+  free(levelcache.buffer);
+  free(levelcache.path);
+
+  levelcache.active = false;
+  levelcache.path   = nullptr;
+  levelcache.file   = nullptr;
+  levelcache.image  = nullptr;
+  levelcache.buffer = nullptr;
+  std::fill(std::begin(levelcache.sections), std::end(levelcache.sections), nullptr);
+  levelcache.stored.clear();
+  levelcache.storeddata.clear();
+}
+
+static const levelcache_section_t * LevelCacheSection(levelcache_section_e type, const uint8_t ** data) {
+  const levelcache_section_t * section = levelcache.active ? levelcache.sections[type] : nullptr;
+
+  if (section != nullptr) {
+    *data = levelcache.image + section->offset;
+  }
+
+  return section;
+}
+
+static void LevelCacheStore(levelcache_section_e type, uint32_t count, const void * data, size_t length) {
+  // nothing to add to an entry that was found
+  if (!levelcache.active || levelcache.image != nullptr) {
+    return;
+  }
+
+  levelcache.stored.push_back({ type, count, static_cast<uint32_t>(levelcache.storeddata.size()), static_cast<uint32_t>(length) });
+
+  const auto * bytes = static_cast<const uint8_t *>(data);
+  levelcache.storeddata.insert(levelcache.storeddata.end(), bytes, bytes + length);
+  levelcache.storeddata.resize((levelcache.storeddata.size() + 7) & ~static_cast<size_t>(7));
+}
+
+bool P_LevelCacheBlockMap() {
+  const uint8_t *              data;
+  const levelcache_section_t * section = LevelCacheSection(LCS_BLOCKMAP, &data);
+
+  if (section == nullptr || section->count < 6 || section->length != section->count * sizeof(int32_t)) {
+    return false;
+  }
+
+  const auto * lump = reinterpret_cast<const int32_t *>(data);
+
+  // negative sizes would wrap around in the product
+  if (lump[2] <= 0 || lump[3] <= 0 || static_cast<size_t>(lump[2]) * static_cast<size_t>(lump[3]) + 6 > section->count) {
+    return false;
+  }
+
+  g_p_local_blockmap->blockmaplump = zmalloc<decltype(g_p_local_blockmap->blockmaplump)>(section->length, PU_LEVEL, nullptr);
+  std::memcpy(g_p_local_blockmap->blockmaplump, lump, section->length);
+  g_p_local_blockmap->blockmap = g_p_local_blockmap->blockmaplump + 4;
+
+  g_p_local_blockmap->bmaporgx   = lump[0] << FRACBITS;
+  g_p_local_blockmap->bmaporgy   = lump[1] << FRACBITS;
+  g_p_local_blockmap->bmapwidth  = lump[2];
+  g_p_local_blockmap->bmapheight = lump[3];
+
+  const size_t count             = sizeof(*g_p_local_blockmap->blocklinks) * static_cast<size_t>(g_p_local_blockmap->bmapwidth * g_p_local_blockmap->bmapheight);
+  g_p_local_blockmap->blocklinks = zmalloc<decltype(g_p_local_blockmap->blocklinks)>(count, PU_LEVEL, nullptr);
+  std::memset(g_p_local_blockmap->blocklinks, 0, count);
+
+  fmt::fprintf(stderr, "+cached BLOCKMAP)\n");
+  return true;
+}
+
+void P_LevelCacheStoreBlockMap(int count) {
+  if (!levelcache.active || levelcache.image != nullptr) {
+    return;
+  }
+
+  // a built BLOCKMAP leaves the header words unset
+  std::vector<int32_t> lump(g_p_local_blockmap->blockmaplump, g_p_local_blockmap->blockmaplump + count);
+  lump[0] = g_p_local_blockmap->bmaporgx >> FRACBITS;
+  lump[1] = g_p_local_blockmap->bmaporgy >> FRACBITS;
+  lump[2] = g_p_local_blockmap->bmapwidth;
+  lump[3] = g_p_local_blockmap->bmapheight;
+
+  LevelCacheStore(LCS_BLOCKMAP, static_cast<uint32_t>(count), lump.data(), lump.size() * sizeof(int32_t));
+}
+
+const uint8_t * P_LevelCacheNodes(size_t * length) {
+  const uint8_t *              data;
+  const levelcache_section_t * section = LevelCacheSection(LCS_NODES, &data);
+
+  if (section == nullptr || section->length != section->count) {
+    return nullptr;
+  }
+
+  *length = section->length;
+  return data;
+}
+
+void P_LevelCacheStoreNodes(const uint8_t * data, size_t length) {
+  LevelCacheStore(LCS_NODES, static_cast<uint32_t>(length), data, length);
+}
+
+bool P_LevelCacheSlimeTrails() {
+  const uint8_t *              data;
+  const levelcache_section_t * section = LevelCacheSection(LCS_SLIMETRAILS, &data);
+
+  if (section == nullptr || section->count != static_cast<uint32_t>(g_r_state_globals->numvertexes)
+      || section->length != section->count * 2 * sizeof(fixed_t)) {
+    return false;
+  }
+
+  const auto * coords = reinterpret_cast<const fixed_t *>(data);
+
+  for (int i = 0; i < g_r_state_globals->numvertexes; i++) {
+    g_r_state_globals->vertexes[i].r_x = coords[i * 2];
+    g_r_state_globals->vertexes[i].r_y = coords[i * 2 + 1];
+  }
+
+  return true;
+}
+
+void P_LevelCacheStoreSlimeTrails() {
+  if (!levelcache.active || levelcache.image != nullptr) {
+    return;
+  }
+
+  std::vector<fixed_t> coords;
+  coords.reserve(static_cast<size_t>(g_r_state_globals->numvertexes) * 2);
+
+  for (int i = 0; i < g_r_state_globals->numvertexes; i++) {
+    coords.push_back(g_r_state_globals->vertexes[i].r_x);
+    coords.push_back(g_r_state_globals->vertexes[i].r_y);
+  }
+
+  LevelCacheStore(LCS_SLIMETRAILS, static_cast<uint32_t>(g_r_state_globals->numvertexes), coords.data(), coords.size() * sizeof(fixed_t));
+}
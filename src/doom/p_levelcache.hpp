@@ -0,0 +1,41 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	[crispy] On-disk cache of level data derived at setup time
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Look up the cache entry of the map at lumpnum, if the map needs
+// data that is expensive to derive (a rebuilt BLOCKMAP, or compressed
+// nodes). Otherwise the calls below find nothing and store nothing.
+void P_LevelCacheOpen(int lumpnum, bool needed);
+
+// Write the entry, if it was missing, and release it.
+void P_LevelCacheClose();
+
+// Install the cached BLOCKMAP, as P_StartCreateBlockMap() would build it.
+bool P_LevelCacheBlockMap();
+void P_LevelCacheStoreBlockMap(int count);
+
+// The inflated ZDBSP nodes stream, following the "ZNOD" signature.
+const uint8_t * P_LevelCacheNodes(size_t * length);
+void            P_LevelCacheStoreNodes(const uint8_t * data, size_t length);
+
+// The rendering coordinates of all vertexes, after P_RemoveSlimeTrails().
+bool P_LevelCacheSlimeTrails();
+void P_LevelCacheStoreSlimeTrails();
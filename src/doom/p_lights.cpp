@@ -183,23 +183,19 @@ void EV_TurnTagLightsOff(line_t * line) {
   int        min;
   sector_t * sector;
   sector_t * tsec;
-  line_t *   templine;
 
-  sector = g_r_state_globals->sectors;
-
-  for (int j = 0; j < g_r_state_globals->numsectors; j++, sector++) {
-    if (sector->tag == line->tag) {
-      min = sector->lightlevel;
-      for (int i = 0; i < sector->linecount; i++) {
-        templine = sector->lines[i];
-        tsec     = getNextSector(templine, sector);
-        if (!tsec)
-          continue;
-        if (tsec->lightlevel < min)
-          min = tsec->lightlevel;
-      }
-      sector->lightlevel = static_cast<short>(min);
+  int secnum = -1;
+  while ((secnum = P_FindSectorFromTag(line->tag, secnum)) >= 0) {
+    sector = &g_r_state_globals->sectors[secnum];
+    min    = sector->lightlevel;
+    for (int i = 0; i < sector->adjcount; i++) {
+      tsec = sector->adjacent[i].sector;
+      if (!tsec)
+        continue;
+      if (tsec->lightlevel < min)
+        min = tsec->lightlevel;
     }
+    sector->lightlevel = static_cast<short>(min);
   }
 }
 
@@ -210,29 +206,26 @@ void EV_LightTurnOn(line_t * line,
                     int      bright) {
   sector_t * sector;
   sector_t * temp;
-  line_t *   templine;
-
-  sector = g_r_state_globals->sectors;
-
-  for (int i = 0; i < g_r_state_globals->numsectors; i++, sector++) {
-    if (sector->tag == line->tag) {
-      // bright = 0 means to search
-      // for highest light level
-      // surrounding sector
-      if (!bright) {
-        for (int j = 0; j < sector->linecount; j++) {
-          templine = sector->lines[j];
-          temp     = getNextSector(templine, sector);
-
-          if (!temp)
-            continue;
-
-          if (temp->lightlevel > bright)
-            bright = temp->lightlevel;
-        }
+
+  int secnum = -1;
+  while ((secnum = P_FindSectorFromTag(line->tag, secnum)) >= 0) {
+    sector = &g_r_state_globals->sectors[secnum];
+
+    // bright = 0 means to search
+    // for highest light level
+    // surrounding sector
+    if (!bright) {
+      for (int j = 0; j < sector->adjcount; j++) {
+        temp = sector->adjacent[j].sector;
+
+        if (!temp)
+          continue;
+
+        if (temp->lightlevel > bright)
+          bright = temp->lightlevel;
       }
-      sector->lightlevel = static_cast<short>(bright);
     }
+    sector->lightlevel = static_cast<short>(bright);
   }
 }
 
@@ -164,6 +164,8 @@ bool P_PathTraverse(fixed_t x1,
 
 void P_UnsetThingPosition(mobj_t * thing);
 void P_SetThingPosition(mobj_t * thing);
+void P_InitSecNodes();
+void P_SyncSecNodes();
 
 // fraggle: I have increased the size of this buffer.  In the original Doom,
 // overrunning past this limit caused other bits of memory to be overwritten,
@@ -181,6 +183,8 @@ bool P_TryMove(mobj_t * thing, fixed_t x, fixed_t y);
 bool P_TeleportMove(mobj_t * thing, fixed_t x, fixed_t y);
 void P_SlideMove(mobj_t * mo);
 bool P_CheckSight(mobj_t * t1, mobj_t * t2);
+void P_PrecomputeSight();
+void P_ClearPrecomputedSight();
 void P_UseLines(player_t * player);
 
 bool P_ChangeSector(sector_t * sector, bool crunch);
@@ -1394,10 +1394,36 @@ bool P_ChangeSector(sector_t * sector,
   nofit       = false;
   crushchange = crunch;
 
-  // re-check heights for all things near the moving sector
-  for (int x = sector->blockbox.get(box_e::left); x <= sector->blockbox.get(box_e::right); x++)
-    for (int y = sector->blockbox.get(box_e::bottom); y <= sector->blockbox.get(box_e::top); y++)
-      P_BlockThingsIterator(x, y, PIT_ChangeSector);
+  // Demos and netgames need the vanilla blockmap order,
+  // crushing damage and blood consume P_Random.
+  if (!crispy->singleplayer) {
+    // re-check heights for all things near the moving sector
+    for (int x = sector->blockbox.get(box_e::left); x <= sector->blockbox.get(box_e::right); x++)
+      for (int y = sector->blockbox.get(box_e::bottom); y <= sector->blockbox.get(box_e::top); y++)
+        P_BlockThingsIterator(x, y, PIT_ChangeSector);
+
+    return nofit;
+  }
+
+  // re-check heights only for the things touching the sector
+  P_SyncSecNodes();
+
+  msecnode_t * node;
+
+  for (node = sector->touching_thinglist; node; node = node->m_snext)
+    node->visited = false;
+
+  // PIT_ChangeSector can add or remove nodes, so start over
+  // from the head after each thing.
+  do {
+    for (node = sector->touching_thinglist; node; node = node->m_snext) {
+      if (!node->visited) {
+        node->visited = true;
+        PIT_ChangeSector(node->m_thing);
+        break;
+      }
+    }
+  } while (node);
 
   return nofit;
 }
@@ -20,6 +20,7 @@
 //	and some PIT_* functions to use for iteration.
 //
 
+#include <algorithm>
 #include <cstdlib>
 
 #include <fmt/printf.h>
@@ -27,6 +28,7 @@
 #include "i_system.hpp" // [crispy] I_Realloc()
 #include "m_bbox.hpp"
 #include "m_mapmath.hpp"
+#include "memory.hpp"
 
 #include "doomdef.hpp"
 #include "doomstat.hpp"
@@ -224,6 +226,155 @@ void P_LineOpening(line_t * linedef_param) {
   g_p_local_globals->openrange = g_p_local_globals->opentop - g_p_local_globals->openbottom;
 }
 
+//
+// SECTOR NODES
+// Each thing in the blockmap keeps the list of sectors its
+// bounding box touches, and each sector the list of things
+// touching it, so P_ChangeSector can visit just those.
+// Only kept in single player, demos and netgames never read them.
+//
+static msecnode_t * headsecnode; // free list of nodes
+static bool         secnodes_kept;
+
+//
+// P_InitSecNodes
+// The nodes live in PU_LEVEL memory, forget them on level change.
+//
+void P_InitSecNodes() {
+  headsecnode   = nullptr;
+  secnodes_kept = crispy->singleplayer;
+}
+
+static msecnode_t * P_GetSecnode() {
+  msecnode_t * node = headsecnode;
+
+  if (node)
+    headsecnode = node->m_snext;
+  else
+    node = zmalloc<msecnode_t *>(sizeof(*node), PU_LEVEL, nullptr);
+
+  return node;
+}
+
+static void P_PutSecnode(msecnode_t * node) {
+  node->m_snext = headsecnode;
+  headsecnode   = node;
+}
+
+static void P_AddSecnode(sector_t * sec, mobj_t * thing) {
+  for (msecnode_t * node = thing->touching_sectorlist; node; node = node->m_tnext) {
+    if (node->m_sector == sec)
+      return; // already there
+  }
+
+  msecnode_t * node = P_GetSecnode();
+  node->visited     = false;
+  node->m_sector    = sec;
+  node->m_thing     = thing;
+
+  node->m_tprev = nullptr;
+  node->m_tnext = thing->touching_sectorlist;
+  if (node->m_tnext)
+    node->m_tnext->m_tprev = node;
+  thing->touching_sectorlist = node;
+
+  node->m_sprev = nullptr;
+  node->m_snext = sec->touching_thinglist;
+  if (node->m_snext)
+    node->m_snext->m_sprev = node;
+  sec->touching_thinglist = node;
+}
+
+static void P_DelSecnodes(mobj_t * thing) {
+  msecnode_t * node = thing->touching_sectorlist;
+
+  while (node) {
+    msecnode_t * next = node->m_tnext;
+
+    if (node->m_sprev)
+      node->m_sprev->m_snext = node->m_snext;
+    else
+      node->m_sector->touching_thinglist = node->m_snext;
+
+    if (node->m_snext)
+      node->m_snext->m_sprev = node->m_sprev;
+
+    P_PutSecnode(node);
+    node = next;
+  }
+
+  thing->touching_sectorlist = nullptr;
+}
+
+//
+// P_CreateSecnodes
+// Walks the blockmap lines under the thing's bounding box itself
+// instead of using P_BlockLinesIterator, so validcount is left alone
+// for whoever is iterating when a thing gets (re)positioned.
+//
+static void P_CreateSecnodes(mobj_t * thing) {
+  bounding_box_t box;
+  box.set(box_e::top, thing->y + thing->radius);
+  box.set(box_e::bottom, thing->y - thing->radius);
+  box.set(box_e::right, thing->x + thing->radius);
+  box.set(box_e::left, thing->x - thing->radius);
+
+  P_AddSecnode(thing->subsector->sector, thing);
+
+  const int xl = std::max(0, (box.get(box_e::left) - g_p_local_blockmap->bmaporgx) >> MAPBLOCKSHIFT);
+  const int xh = std::min(g_p_local_blockmap->bmapwidth - 1, (box.get(box_e::right) - g_p_local_blockmap->bmaporgx) >> MAPBLOCKSHIFT);
+  const int yl = std::max(0, (box.get(box_e::bottom) - g_p_local_blockmap->bmaporgy) >> MAPBLOCKSHIFT);
+  const int yh = std::min(g_p_local_blockmap->bmapheight - 1, (box.get(box_e::top) - g_p_local_blockmap->bmaporgy) >> MAPBLOCKSHIFT);
+
+  for (int bx = xl; bx <= xh; bx++) {
+    for (int by = yl; by <= yh; by++) {
+      int offset = *(g_p_local_blockmap->blockmap + by * g_p_local_blockmap->bmapwidth + bx);
+
+      for (int32_t * list = g_p_local_blockmap->blockmaplump + offset; *list != -1; list++) {
+        line_t * ld = &g_r_state_globals->lines[*list];
+
+        if (box.is_outside(ld->bbox))
+          continue;
+
+        if (P_BoxOnLineSide(box, ld) != -1)
+          continue;
+
+        if (ld->frontsector)
+          P_AddSecnode(ld->frontsector, thing);
+
+        if (ld->backsector)
+          P_AddSecnode(ld->backsector, thing);
+      }
+    }
+  }
+}
+
+//
+// P_SyncSecNodes
+// Start or stop keeping the lists when single player is switched
+// on or off during a level, e.g. when a demo recording ends.
+//
+void P_SyncSecNodes() {
+  if (secnodes_kept == crispy->singleplayer)
+    return;
+
+  secnodes_kept = crispy->singleplayer;
+
+  action_hook needle = P_MobjThinker;
+  for (thinker_t * th = g_p_local_globals->thinkercap.next; th != &g_p_local_globals->thinkercap; th = th->next) {
+    if (th->function != needle)
+      continue;
+
+    auto * thing = reinterpret_cast<mobj_t *>(th);
+
+    if (!secnodes_kept)
+      P_DelSecnodes(thing);
+    else if (!(thing->flags & MF_NOBLOCKMAP))
+      if (secnodes_kept)
+      P_CreateSecnodes(thing);
+  }
+}
+
 //
 // THING POSITION SETTING
 //
@@ -269,6 +420,8 @@ void P_UnsetThingPosition(mobj_t * thing) {
       }
     }
   }
+
+  P_DelSecnodes(thing);
 }
 
 //
@@ -322,6 +475,8 @@ void P_SetThingPosition(mobj_t * thing) {
       // thing is off the map
       thing->bnext = thing->bprev = nullptr;
     }
+
+    P_CreateSecnodes(thing);
   }
 }
 
@@ -555,6 +710,29 @@ bool PIT_AddThingIntercepts(mobj_t * thing) {
   return true; // keep going
 }
 
+//
+// P_SortIntercepts
+// Stable insertion sort by frac.  Taking the intercepts in this
+// order is exactly what the repeated closest-first scan does,
+// ties included, so it is safe for demos.  The intercepts are
+// added walking the blockmap along the trace, so they arrive
+// nearly sorted and this stays close to linear.
+//
+static void P_SortIntercepts(intercept_t * first, intercept_t * last) {
+  for (intercept_t * i = first + 1; i < last; i++) {
+    intercept_t   in   = *i;
+    intercept_t * scan = i;
+
+    for (; scan > first && (scan - 1)->frac > in.frac; scan--)
+      *scan = *(scan - 1);
+
+    *scan = in;
+  }
+}
+
+// Below this many intercepts the closest-first scan is cheaper than sorting.
+constexpr auto SORTINTERCEPTS_MIN = 8;
+
 //
 // P_TraverseIntercepts
 // Returns true if the traverser function returns true
@@ -563,6 +741,20 @@ bool PIT_AddThingIntercepts(mobj_t * thing) {
 bool P_TraverseIntercepts(traverser_t func, fixed_t maxfrac) {
   int count = static_cast<int>(g_p_local_globals->intercept_p - intercepts);
 
+  if (count >= SORTINTERCEPTS_MIN) {
+    P_SortIntercepts(intercepts, g_p_local_globals->intercept_p);
+
+    for (intercept_t * in = intercepts; in < g_p_local_globals->intercept_p; in++) {
+      if (in->frac > maxfrac)
+        return true; // checked everything in range
+
+      if (!func(in))
+        return false; // don't bother going farther
+    }
+
+    return true; // everything was traversed
+  }
+
   intercept_t * in = 0; // shut up compiler warning
 
   while (count--) {
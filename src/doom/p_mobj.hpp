@@ -283,4 +283,7 @@ struct mobj_t {
   fixed_t oldy {};
   fixed_t oldz {};
   angle_t oldangle {};
+
+  // All sectors the bounding box touches, see P_SetThingPosition.
+  struct msecnode_t * touching_sectorlist {};
 };
@@ -17,12 +17,14 @@
 //
 
 #include <cstdlib>
+#include <unordered_map>
 
 #include <fmt/printf.h>
 
 #include "deh_main.hpp"
 #include "dstrings.hpp"
 #include "i_system.hpp"
+#include "p_blockmap.hpp"
 #include "p_local.hpp"
 #include "p_saveg.hpp"
 #include "z_zone.hpp"
@@ -39,6 +41,10 @@ FILE *               save_stream;
 bool                 savegame_error;
 static int           restoretargets_fail;
 
+// [crispy] in-memory savegame stream, replaces save_stream while set
+static std::vector<uint8_t> * save_buffer;
+static size_t                 save_buffer_pos;
+
 // Get the filename of a temporary file to write the savegame to.  After
 // the file has been successfully saved, it will be renamed to the
 // real file.
@@ -78,7 +84,17 @@ char * P_SaveGameFile(int slot) {
 static uint8_t saveg_read8() {
   auto result = static_cast<uint8_t>(-1);
 
-  if (fread(&result, 1, 1, save_stream) < 1) {
+  bool ok = false;
+
+  if (save_buffer) {
+    ok = save_buffer_pos < save_buffer->size();
+    if (ok)
+      result = (*save_buffer)[save_buffer_pos++];
+  } else {
+    ok = fread(&result, 1, 1, save_stream) == 1;
+  }
+
+  if (!ok) {
     if (!savegame_error) {
       fmt::fprintf(stderr, "saveg_read8: Unexpected end of file while "
                            "reading save game\n");
@@ -91,7 +107,10 @@ static uint8_t saveg_read8() {
 }
 
 static void saveg_write8(uint8_t value) {
-  if (fwrite(&value, 1, 1, save_stream) < 1) {
+  if (save_buffer) {
+    save_buffer->push_back(value);
+    save_buffer_pos++;
+  } else if (fwrite(&value, 1, 1, save_stream) < 1) {
     if (!savegame_error) {
       fmt::fprintf(stderr, "saveg_write8: Error while writing save game\n");
 
@@ -128,10 +147,18 @@ static void saveg_write32(int value) {
   saveg_write8(static_cast<uint8_t>((value >> 24) & 0xff));
 }
 
+static unsigned long saveg_tell() {
+  if (save_buffer) {
+    return save_buffer_pos;
+  }
+
+  return static_cast<unsigned long>(ftell(save_stream));
+}
+
 // Pad to 4-byte boundaries
 
 static void saveg_read_pad() {
-  auto pos = static_cast<unsigned long>(ftell(save_stream));
+  auto pos = saveg_tell();
 
   int padding = (4 - (pos & 3)) & 3;
 
@@ -141,7 +168,7 @@ static void saveg_read_pad() {
 }
 
 static void saveg_write_pad() {
-  auto pos = static_cast<unsigned long>(ftell(save_stream));
+  auto pos = saveg_tell();
 
   int padding = (4 - (pos & 3)) & 3;
 
@@ -150,6 +177,51 @@ static void saveg_write_pad() {
   }
 }
 
+// [crispy] redirect savegame I/O to a memory buffer instead of save_stream.
+// Writes are appended to the buffer, reads start at its beginning.
+// Pass nullptr to go back to save_stream.
+
+void P_OpenSaveGameBuffer(std::vector<uint8_t> * buffer) {
+  save_buffer     = buffer;
+  save_buffer_pos = 0;
+}
+
+bool P_SaveGameInMemory() {
+  return save_buffer != nullptr;
+}
+
+// [crispy] line based I/O for the extended savegame data
+
+void P_WriteSaveGameString(const char * str) {
+  if (save_buffer) {
+    for (; *str; str++)
+      saveg_write8(static_cast<uint8_t>(*str));
+  } else {
+    fputs(str, save_stream);
+  }
+}
+
+char * P_ReadSaveGameString(char * str, int size) {
+  if (!save_buffer) {
+    return fgets(str, size, save_stream);
+  }
+
+  if (save_buffer_pos >= save_buffer->size() || size < 2) {
+    return nullptr;
+  }
+
+  int i = 0;
+  while (i < size - 1 && save_buffer_pos < save_buffer->size()) {
+    char c   = static_cast<char>((*save_buffer)[save_buffer_pos++]);
+    str[i++] = c;
+    if (c == '\n')
+      break;
+  }
+  str[i] = '\0';
+
+  return str;
+}
+
 // Pointers
 
 static void * saveg_readp() {
@@ -1295,6 +1367,48 @@ static void saveg_write_glow_t(glow_t * str) {
   saveg_write32(str->direction);
 }
 
+//
+// fireflicker_t
+//
+// [crispy] only used by in-memory snapshots, savegames keep
+// fire flickers in the extended savegame data
+//
+
+static void saveg_read_fireflicker_t(fireflicker_t * str) {
+  // thinker_t thinker;
+  saveg_read_thinker_t(&str->thinker);
+
+  // sector_t* sector;
+  int sector  = saveg_read32();
+  str->sector = &g_r_state_globals->sectors[sector];
+
+  // int count;
+  str->count = saveg_read32();
+
+  // int maxlight;
+  str->maxlight = saveg_read32();
+
+  // int minlight;
+  str->minlight = saveg_read32();
+}
+
+static void saveg_write_fireflicker_t(fireflicker_t * str) {
+  // thinker_t thinker;
+  saveg_write_thinker_t(&str->thinker);
+
+  // sector_t* sector;
+  saveg_write32(static_cast<int>(str->sector - g_r_state_globals->sectors));
+
+  // int count;
+  saveg_write32(str->count);
+
+  // int maxlight;
+  saveg_write32(str->maxlight);
+
+  // int minlight;
+  saveg_write32(str->minlight);
+}
+
 //
 // Write the header for a savegame
 //
@@ -1499,6 +1613,9 @@ void P_UnArchiveWorld() {
       si->midtexture    = saveg_read16();
     }
   }
+
+  // tags came from the savegame
+  P_InitTagLists();
 }
 
 //
@@ -1533,15 +1650,29 @@ void P_ArchiveThinkers() {
   saveg_write8(tc_end);
 }
 
-//
-// P_UnArchiveThinkers
-//
-void P_UnArchiveThinkers() {
-  uint8_t     tclass = 0;
+static mobj_t * saveg_read_mobj() {
+  auto * mobj = zmalloc<mobj_t *>(sizeof(mobj_t), PU_LEVEL, nullptr);
+  saveg_read_mobj_t(mobj);
+
+  // [crispy] restore mobj->target and mobj->tracer fields
+  // mobj->target = nullptr;
+  // mobj->tracer = nullptr;
+  mobj->touching_sectorlist = nullptr;
+  P_SetThingPosition(mobj);
+  mobj->info = &mobjinfo[mobj->type];
+  // [crispy] killough 2/28/98: Fix for falling down into a wall after savegame loaded
+  //	    mobj->floorz = mobj->subsector->sector->floorheight;
+  //	    mobj->ceilingz = mobj->subsector->sector->ceilingheight;
+  mobj->thinker.function = P_MobjThinker;
+  P_AddThinker(&mobj->thinker);
+
+  return mobj;
+}
+
+// remove all the current thinkers
+static void P_RemoveAllThinkers() {
   thinker_t * next = nullptr;
-  mobj_t *    mobj = nullptr;
 
-  // remove all the current thinkers
   thinker_t * currentthinker = g_p_local_globals->thinkercap.next;
   action_hook needle = P_MobjThinker;
   while (currentthinker != &g_p_local_globals->thinkercap) {
@@ -1555,6 +1686,15 @@ void P_UnArchiveThinkers() {
     currentthinker = next;
   }
   P_InitThinkers();
+}
+
+//
+// P_UnArchiveThinkers
+//
+void P_UnArchiveThinkers() {
+  uint8_t tclass = 0;
+
+  P_RemoveAllThinkers();
 
   // read in saved thinkers
   while (true) {
@@ -1565,19 +1705,7 @@ void P_UnArchiveThinkers() {
 
     case tc_mobj:
       saveg_read_pad();
-      mobj = zmalloc<decltype(mobj)>(sizeof(*mobj), PU_LEVEL, nullptr);
-      saveg_read_mobj_t(mobj);
-
-      // [crispy] restore mobj->target and mobj->tracer fields
-      // mobj->target = nullptr;
-      // mobj->tracer = nullptr;
-      P_SetThingPosition(mobj);
-      mobj->info = &mobjinfo[mobj->type];
-      // [crispy] killough 2/28/98: Fix for falling down into a wall after savegame loaded
-      //	    mobj->floorz = mobj->subsector->sector->floorheight;
-      //	    mobj->ceilingz = mobj->subsector->sector->ceilingheight;
-      mobj->thinker.function = P_MobjThinker;
-      P_AddThinker(&mobj->thinker);
+      saveg_read_mobj();
       break;
 
     default:
@@ -1618,8 +1746,11 @@ enum class specials_e
   tc_flash,
   tc_strobe,
   tc_glow,
-  tc_endspecials
+  tc_endspecials,
 
+  // [crispy] only used by in-memory snapshots
+  tc_snapmobj,
+  tc_fireflicker
 };
 
 //
@@ -1633,8 +1764,7 @@ enum class specials_e
 // T_Glow, (glow_t: sector_t *),
 // T_PlatRaise, (plat_t: sector_t *), - active list
 //
-void P_ArchiveSpecials() {
-  // save off the current thinkers
+static void saveg_write_special(thinker_t * th) {
   action_hook null_needle          = null_hook();
   action_hook needle_move_ceiling  = T_MoveCeiling;
   action_hook needle_vertical_door = T_VerticalDoor;
@@ -1643,91 +1773,92 @@ void P_ArchiveSpecials() {
   action_hook needle_light_flash   = T_LightFlash;
   action_hook needle_strobe_flash  = T_StrobeFlash;
   action_hook needle_glow          = T_Glow;
-  for (thinker_t * th = g_p_local_globals->thinkercap.next; th != &g_p_local_globals->thinkercap; th = th->next) {
-    if (th->function == null_needle) {
-      int index1 = 0;
-      for (index1 = 0; index1 < MAXCEILINGS; index1++)
-        if (activeceilings[index1] == reinterpret_cast<ceiling_t *>(th))
-          break;
-
-      if (index1 < MAXCEILINGS) {
-        saveg_write8(static_cast<uint8_t>(specials_e::tc_ceiling));
-        saveg_write_pad();
-        saveg_write_ceiling_t(reinterpret_cast<ceiling_t *>(th));
-      }
-      // [crispy] save plats in statis
-      int index2 = 0;
-      for (index2 = 0; index2 < MAXPLATS; index2++)
-        if (activeplats[index2] == reinterpret_cast<plat_t *>(th))
-          break;
-
-      if (index2 < MAXPLATS) {
-        saveg_write8(static_cast<uint8_t>(specials_e::tc_plat));
-        saveg_write_pad();
-        saveg_write_plat_t(reinterpret_cast<plat_t *>(th));
-      }
-      continue;
-    }
 
-    if (th->function == needle_move_ceiling) {
+  if (th->function == null_needle) {
+    int index1 = 0;
+    for (index1 = 0; index1 < MAXCEILINGS; index1++)
+      if (activeceilings[index1] == reinterpret_cast<ceiling_t *>(th))
+        break;
+
+    if (index1 < MAXCEILINGS) {
       saveg_write8(static_cast<uint8_t>(specials_e::tc_ceiling));
       saveg_write_pad();
       saveg_write_ceiling_t(reinterpret_cast<ceiling_t *>(th));
-      continue;
-    }
-
-    if (th->function == needle_vertical_door) {
-      saveg_write8(static_cast<uint8_t>(specials_e::tc_door));
-      saveg_write_pad();
-      saveg_write_vldoor_t(reinterpret_cast<vldoor_t *>(th));
-      continue;
-    }
-
-    if (th->function == needle_move_floor) {
-      saveg_write8(static_cast<uint8_t>(specials_e::tc_floor));
-      saveg_write_pad();
-      saveg_write_floormove_t(reinterpret_cast<floormove_t *>(th));
-      continue;
     }
+    // [crispy] save plats in statis
+    int index2 = 0;
+    for (index2 = 0; index2 < MAXPLATS; index2++)
+      if (activeplats[index2] == reinterpret_cast<plat_t *>(th))
+        break;
 
-    if (th->function == needle_plat_raise) {
+    if (index2 < MAXPLATS) {
       saveg_write8(static_cast<uint8_t>(specials_e::tc_plat));
       saveg_write_pad();
       saveg_write_plat_t(reinterpret_cast<plat_t *>(th));
-      continue;
     }
+    return;
+  }
 
-    if (th->function == needle_light_flash) {
-      saveg_write8(static_cast<uint8_t>(specials_e::tc_flash));
-      saveg_write_pad();
-      saveg_write_lightflash_t(reinterpret_cast<lightflash_t *>(th));
-      continue;
-    }
+  if (th->function == needle_move_ceiling) {
+    saveg_write8(static_cast<uint8_t>(specials_e::tc_ceiling));
+    saveg_write_pad();
+    saveg_write_ceiling_t(reinterpret_cast<ceiling_t *>(th));
+    return;
+  }
 
-    if (th->function == needle_strobe_flash) {
-      saveg_write8(static_cast<uint8_t>(specials_e::tc_strobe));
-      saveg_write_pad();
-      saveg_write_strobe_t(reinterpret_cast<strobe_t *>(th));
-      continue;
-    }
+  if (th->function == needle_vertical_door) {
+    saveg_write8(static_cast<uint8_t>(specials_e::tc_door));
+    saveg_write_pad();
+    saveg_write_vldoor_t(reinterpret_cast<vldoor_t *>(th));
+    return;
+  }
 
-    if (th->function == needle_glow) {
-      saveg_write8(static_cast<uint8_t>(specials_e::tc_glow));
-      saveg_write_pad();
-      saveg_write_glow_t(reinterpret_cast<glow_t *>(th));
-      continue;
-    }
+  if (th->function == needle_move_floor) {
+    saveg_write8(static_cast<uint8_t>(specials_e::tc_floor));
+    saveg_write_pad();
+    saveg_write_floormove_t(reinterpret_cast<floormove_t *>(th));
+    return;
+  }
+
+  if (th->function == needle_plat_raise) {
+    saveg_write8(static_cast<uint8_t>(specials_e::tc_plat));
+    saveg_write_pad();
+    saveg_write_plat_t(reinterpret_cast<plat_t *>(th));
+    return;
+  }
+
+  if (th->function == needle_light_flash) {
+    saveg_write8(static_cast<uint8_t>(specials_e::tc_flash));
+    saveg_write_pad();
+    saveg_write_lightflash_t(reinterpret_cast<lightflash_t *>(th));
+    return;
+  }
+
+  if (th->function == needle_strobe_flash) {
+    saveg_write8(static_cast<uint8_t>(specials_e::tc_strobe));
+    saveg_write_pad();
+    saveg_write_strobe_t(reinterpret_cast<strobe_t *>(th));
+    return;
+  }
+
+  if (th->function == needle_glow) {
+    saveg_write8(static_cast<uint8_t>(specials_e::tc_glow));
+    saveg_write_pad();
+    saveg_write_glow_t(reinterpret_cast<glow_t *>(th));
+  }
+}
+
+void P_ArchiveSpecials() {
+  // save off the current thinkers
+  for (thinker_t * th = g_p_local_globals->thinkercap.next; th != &g_p_local_globals->thinkercap; th = th->next) {
+    saveg_write_special(th);
   }
 
   // add a terminating marker
   saveg_write8(static_cast<uint8_t>(specials_e::tc_endspecials));
 }
 
-//
-// P_UnArchiveSpecials
-//
-void P_UnArchiveSpecials() {
-  specials_e     tclass;
+static void saveg_read_special(specials_e tclass) {
   ceiling_t *    ceiling = nullptr;
   vldoor_t *     door    = nullptr;
   floormove_t *  floor   = nullptr;
@@ -1736,86 +1867,234 @@ void P_UnArchiveSpecials() {
   strobe_t *     strobe  = nullptr;
   glow_t *       glow    = nullptr;
 
+  switch (tclass) {
+  case specials_e::tc_ceiling:
+    saveg_read_pad();
+    ceiling = zmalloc<decltype(ceiling)>(sizeof(*ceiling), PU_LEVEL, nullptr);
+    saveg_read_ceiling_t(ceiling);
+    ceiling->sector->specialdata = ceiling;
+
+    if (action_hook_has_value(ceiling->thinker.function))
+      ceiling->thinker.function = T_MoveCeiling;
+
+    P_AddThinker(&ceiling->thinker);
+    P_AddActiveCeiling(ceiling);
+    break;
+
+  case specials_e::tc_door:
+    saveg_read_pad();
+    door = zmalloc<decltype(door)>(sizeof(*door), PU_LEVEL, nullptr);
+    saveg_read_vldoor_t(door);
+    door->sector->specialdata = door;
+    door->thinker.function    = T_VerticalDoor;
+    P_AddThinker(&door->thinker);
+    break;
+
+  case specials_e::tc_floor:
+    saveg_read_pad();
+    floor = zmalloc<decltype(floor)>(sizeof(*floor), PU_LEVEL, nullptr);
+    saveg_read_floormove_t(floor);
+    floor->sector->specialdata = floor;
+    floor->thinker.function    = T_MoveFloor;
+    P_AddThinker(&floor->thinker);
+    break;
+
+  case specials_e::tc_plat:
+    saveg_read_pad();
+    plat = zmalloc<decltype(plat)>(sizeof(*plat), PU_LEVEL, nullptr);
+    saveg_read_plat_t(plat);
+    plat->sector->specialdata = plat;
+
+    if (action_hook_has_value(plat->thinker.function))
+      plat->thinker.function = T_PlatRaise;
+
+    P_AddThinker(&plat->thinker);
+    P_AddActivePlat(plat);
+    break;
+
+  case specials_e::tc_flash:
+    saveg_read_pad();
+    flash = zmalloc<decltype(flash)>(sizeof(*flash), PU_LEVEL, nullptr);
+    saveg_read_lightflash_t(flash);
+    flash->thinker.function = T_LightFlash;
+    P_AddThinker(&flash->thinker);
+    break;
+
+  case specials_e::tc_strobe:
+    saveg_read_pad();
+    strobe = zmalloc<decltype(strobe)>(sizeof(*strobe), PU_LEVEL, nullptr);
+    saveg_read_strobe_t(strobe);
+    strobe->thinker.function = T_StrobeFlash;
+    P_AddThinker(&strobe->thinker);
+    break;
+
+  case specials_e::tc_glow:
+    saveg_read_pad();
+    glow = zmalloc<decltype(glow)>(sizeof(*glow), PU_LEVEL, nullptr);
+    saveg_read_glow_t(glow);
+    glow->thinker.function = T_Glow;
+    P_AddThinker(&glow->thinker);
+    break;
+
+  default:
+    I_Error("P_UnarchiveSpecials:Unknown tclass %i "
+            "in savegame",
+            static_cast<int>(tclass));
+  }
+}
+
+//
+// P_UnArchiveSpecials
+//
+void P_UnArchiveSpecials() {
+  specials_e tclass;
+
   // read in saved thinkers
   while (true) {
     tclass = static_cast<specials_e>(saveg_read8());
 
-    switch (tclass) {
-    case specials_e::tc_endspecials:
+    if (tclass == specials_e::tc_endspecials)
       return; // end of list
 
-    case specials_e::tc_ceiling:
-      saveg_read_pad();
-      ceiling = zmalloc<decltype(ceiling)>(sizeof(*ceiling), PU_LEVEL, nullptr);
-      saveg_read_ceiling_t(ceiling);
-      ceiling->sector->specialdata = ceiling;
+    saveg_read_special(tclass);
+  }
+}
 
-      if (action_hook_has_value(ceiling->thinker.function))
-        ceiling->thinker.function = T_MoveCeiling;
+//
+// [crispy] in-memory snapshots
+//
+// Demo playback has to continue in sync after a snapshot is restored,
+// so these keep what the savegame format truncates or reorders:
+// full precision plane heights, the thinker list order with mobjs,
+// specials and fire flickers interleaved, the order of the
+// blockmap thing chains, and the item respawn and body queues that
+// G_InitNew() resets.
+//
+void P_ArchiveSnapshot() {
+  int        i   = 0;
+  sector_t * sec = nullptr;
 
-      P_AddThinker(&ceiling->thinker);
-      P_AddActiveCeiling(ceiling);
-      break;
+  for (i = 0, sec = g_r_state_globals->sectors; i < g_r_state_globals->numsectors; i++, sec++) {
+    saveg_write32(sec->floorheight);
+    saveg_write32(sec->ceilingheight);
+  }
 
-    case specials_e::tc_door:
-      saveg_read_pad();
-      door = zmalloc<decltype(door)>(sizeof(*door), PU_LEVEL, nullptr);
-      saveg_read_vldoor_t(door);
-      door->sector->specialdata = door;
-      door->thinker.function    = T_VerticalDoor;
-      P_AddThinker(&door->thinker);
-      break;
+  std::unordered_map<mobj_t *, uint32_t> mobjindex;
+  action_hook                            needle              = P_MobjThinker;
+  action_hook                            needle_fire_flicker = T_FireFlicker;
+  for (thinker_t * th = g_p_local_globals->thinkercap.next; th != &g_p_local_globals->thinkercap; th = th->next) {
+    if (th->function == needle) {
+      const auto index = static_cast<uint32_t>(mobjindex.size() + 1);
+      mobjindex.emplace(reinterpret_cast<mobj_t *>(th), index);
 
-    case specials_e::tc_floor:
-      saveg_read_pad();
-      floor = zmalloc<decltype(floor)>(sizeof(*floor), PU_LEVEL, nullptr);
-      saveg_read_floormove_t(floor);
-      floor->sector->specialdata = floor;
-      floor->thinker.function    = T_MoveFloor;
-      P_AddThinker(&floor->thinker);
-      break;
+      saveg_write8(static_cast<uint8_t>(specials_e::tc_snapmobj));
+      saveg_write_pad();
+      saveg_write_mobj_t(reinterpret_cast<mobj_t *>(th));
+    } else if (th->function == needle_fire_flicker) {
+      saveg_write8(static_cast<uint8_t>(specials_e::tc_fireflicker));
+      saveg_write_pad();
+      saveg_write_fireflicker_t(reinterpret_cast<fireflicker_t *>(th));
+    } else {
+      saveg_write_special(th);
+    }
+  }
+  saveg_write8(static_cast<uint8_t>(specials_e::tc_endspecials));
 
-    case specials_e::tc_plat:
-      saveg_read_pad();
-      plat = zmalloc<decltype(plat)>(sizeof(*plat), PU_LEVEL, nullptr);
-      saveg_read_plat_t(plat);
-      plat->sector->specialdata = plat;
+  const int numblocks = g_p_local_blockmap->bmapwidth * g_p_local_blockmap->bmapheight;
+  for (i = 0; i < numblocks; i++) {
+    for (mobj_t * mo = g_p_local_blockmap->blocklinks[i]; mo; mo = mo->bnext) {
+      auto it = mobjindex.find(mo);
+      if (it != mobjindex.end())
+        saveg_write32(static_cast<int>(it->second));
+    }
+    saveg_write32(0);
+  }
 
-      if (action_hook_has_value(plat->thinker.function))
-        plat->thinker.function = T_PlatRaise;
+  saveg_write32(g_p_local_globals->iquehead);
+  saveg_write32(g_p_local_globals->iquetail);
+  for (i = 0; i < ITEMQUESIZE; i++) {
+    saveg_write_mapthing_t(&g_p_local_globals->itemrespawnque[i]);
+    saveg_write32(g_p_local_globals->itemrespawntime[i]);
+  }
 
-      P_AddThinker(&plat->thinker);
-      P_AddActivePlat(plat);
-      break;
+  saveg_write32(g_doomstat_globals->bodyqueslot);
+  for (auto * mo : bodyque) {
+    auto it = mobjindex.find(mo);
+    saveg_write32(it != mobjindex.end() ? static_cast<int>(it->second) : 0);
+  }
+}
 
-    case specials_e::tc_flash:
-      saveg_read_pad();
-      flash = zmalloc<decltype(flash)>(sizeof(*flash), PU_LEVEL, nullptr);
-      saveg_read_lightflash_t(flash);
-      flash->thinker.function = T_LightFlash;
-      P_AddThinker(&flash->thinker);
-      break;
+void P_UnArchiveSnapshot() {
+  int        i   = 0;
+  sector_t * sec = nullptr;
 
-    case specials_e::tc_strobe:
-      saveg_read_pad();
-      strobe = zmalloc<decltype(strobe)>(sizeof(*strobe), PU_LEVEL, nullptr);
-      saveg_read_strobe_t(strobe);
-      strobe->thinker.function = T_StrobeFlash;
-      P_AddThinker(&strobe->thinker);
+  for (i = 0, sec = g_r_state_globals->sectors; i < g_r_state_globals->numsectors; i++, sec++) {
+    sec->floorheight   = saveg_read32();
+    sec->ceilingheight = saveg_read32();
+  }
+
+  P_RemoveAllThinkers();
+
+  // removing the items has queued them for respawning
+  g_p_local_globals->iquehead = g_p_local_globals->iquetail = 0;
+
+  std::vector<mobj_t *> mobjs(1, nullptr);
+  while (true) {
+    auto tclass = static_cast<specials_e>(saveg_read8());
+
+    if (tclass == specials_e::tc_endspecials)
       break;
 
-    case specials_e::tc_glow:
+    if (tclass == specials_e::tc_snapmobj) {
       saveg_read_pad();
-      glow = zmalloc<decltype(glow)>(sizeof(*glow), PU_LEVEL, nullptr);
-      saveg_read_glow_t(glow);
-      glow->thinker.function = T_Glow;
-      P_AddThinker(&glow->thinker);
-      break;
+      mobjs.push_back(saveg_read_mobj());
+    } else if (tclass == specials_e::tc_fireflicker) {
+      saveg_read_pad();
+      auto * flick = zmalloc<fireflicker_t *>(sizeof(fireflicker_t), PU_LEVEL, nullptr);
+      saveg_read_fireflicker_t(flick);
+      flick->thinker.function = T_FireFlicker;
+      P_AddThinker(&flick->thinker);
+    } else {
+      saveg_read_special(tclass);
+    }
+  }
 
-    default:
-      I_Error("P_UnarchiveSpecials:Unknown tclass %i "
-              "in savegame",
-              static_cast<int>(tclass));
+  // relink the blockmap chains in their saved order
+  for (size_t j = 1; j < mobjs.size(); j++) {
+    if (!(mobjs[j]->flags & MF_NOBLOCKMAP))
+      mobjs[j]->bnext = mobjs[j]->bprev = nullptr;
+  }
+
+  const int numblocks = g_p_local_blockmap->bmapwidth * g_p_local_blockmap->bmapheight;
+  for (i = 0; i < numblocks; i++) {
+    mobj_t ** link = &g_p_local_blockmap->blocklinks[i];
+    mobj_t *  prev = nullptr;
+    int       index;
+
+    *link = nullptr;
+    while ((index = saveg_read32()) != 0 && !savegame_error) {
+      if (index < 0 || static_cast<size_t>(index) >= mobjs.size())
+        continue;
+
+      mobj_t * mo = mobjs[static_cast<size_t>(index)];
+      mo->bprev   = prev;
+      mo->bnext   = nullptr;
+      *link       = mo;
+      link        = &mo->bnext;
+      prev        = mo;
     }
   }
+
+  g_p_local_globals->iquehead = saveg_read32() & (ITEMQUESIZE - 1);
+  g_p_local_globals->iquetail = saveg_read32() & (ITEMQUESIZE - 1);
+  for (i = 0; i < ITEMQUESIZE; i++) {
+    saveg_read_mapthing_t(&g_p_local_globals->itemrespawnque[i]);
+    g_p_local_globals->itemrespawntime[i] = saveg_read32();
+  }
+
+  g_doomstat_globals->bodyqueslot = saveg_read32();
+  for (auto & mo : bodyque) {
+    const int index = saveg_read32();
+    mo              = (index > 0 && static_cast<size_t>(index) < mobjs.size()) ? mobjs[static_cast<size_t>(index)] : nullptr;
+  }
 }
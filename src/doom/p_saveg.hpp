@@ -19,6 +19,8 @@
 #pragma once
 
 #include <cstdio>
+#include <cstdint>
+#include <vector>
 
 constexpr auto SAVEGAME_EOF = 0x1d;
 constexpr auto VERSIONSIZE  = 16;
@@ -57,5 +59,16 @@ void P_ArchiveSpecials();
 void P_UnArchiveSpecials();
 void P_RestoreTargets();
 
+// [crispy] in-memory snapshots, written after P_ArchiveWorld()
+// in place of P_ArchiveThinkers() and P_ArchiveSpecials()
+void P_ArchiveSnapshot();
+void P_UnArchiveSnapshot();
+
+// [crispy] savegame I/O to a memory buffer instead of save_stream
+void   P_OpenSaveGameBuffer(std::vector<uint8_t> * buffer);
+bool   P_SaveGameInMemory();
+void   P_WriteSaveGameString(const char * str);
+char * P_ReadSaveGameString(char * str, int size);
+
 extern FILE * save_stream;
 extern bool   savegame_error;
@@ -17,7 +17,10 @@
 //	set up initial state and misc. LUTs.
 //
 
+#include <algorithm>
 #include <cmath>
+#include <thread>
+#include <vector>
 
 #include <fmt/printf.h>
 
@@ -46,11 +49,39 @@
 #include "lump.hpp"
 #include "memory.hpp"
 #include "p_extnodes.hpp" // [crispy] support extended node formats
+#include "p_levelcache.hpp"
 
 void P_SpawnMapThing(mapthing_t * mthing);
 
 static int totallines;
 
+// [crispy] fewer records than this are decoded on the game thread only
+constexpr int MINPARALLELRECORDS = 4096;
+
+// [crispy] Run fn(first, last) over chunks of [0, count) on worker
+// threads, the game thread taking the first chunk itself. Only for
+// loops that don't allocate from the zone and only write to their
+// own records.
+template <typename F>
+static void P_ParallelFor(int count, F fn) {
+  if (count < MINPARALLELRECORDS) {
+    fn(0, count);
+    return;
+  }
+
+  const int numworkers = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+  const int chunk      = (count + numworkers - 1) / numworkers;
+
+  std::vector<std::thread> workers;
+  for (int first = chunk; first < count; first += chunk)
+    workers.emplace_back(fn, first, std::min(first + chunk, count));
+
+  fn(0, std::min(chunk, count));
+
+  for (auto & worker : workers)
+    worker.join();
+}
+
 // [crispy] recalculate seg offsets
 // adapted from prboom-plus/src/p_setup.c:474-482
 fixed_t GetOffset(vertex_t * v1, vertex_t * v2) {
@@ -254,29 +285,32 @@ void P_LoadSectors(int lump) {
   if (!data || !g_r_state_globals->numsectors)
     I_Error("P_LoadSectors: No sectors in map!");
 
-  auto *     ms = reinterpret_cast<mapsector_t *>(data);
-  sector_t * ss = g_r_state_globals->sectors;
-  for (int i = 0; i < g_r_state_globals->numsectors; i++, ss++, ms++) {
-    ss->floorheight   = SHORT(ms->floorheight) << FRACBITS;
-    ss->ceilingheight = SHORT(ms->ceilingheight) << FRACBITS;
-    ss->floorpic      = static_cast<short>(R_FlatNumForName(ms->floorpic));
-    ss->ceilingpic    = static_cast<short>(R_FlatNumForName(ms->ceilingpic));
-    ss->lightlevel    = SHORT(ms->lightlevel);
-    ss->special       = SHORT(ms->special);
-    ss->tag           = SHORT(ms->tag);
-    ss->thinglist     = nullptr;
-    // [crispy] WiggleFix: [kb] for R_FixWiggle()
-    ss->cachedheight = 0;
-    // [AM] Sector interpolation.  Even if we're
-    //      not running uncapped, the renderer still
-    //      uses this data.
-    ss->oldfloorheight      = ss->floorheight;
-    ss->interpfloorheight   = ss->floorheight;
-    ss->oldceilingheight    = ss->ceilingheight;
-    ss->interpceilingheight = ss->ceilingheight;
-    // [crispy] inhibit sector interpolation during the 0th gametic
-    ss->oldgametic = -1;
-  }
+  // [crispy] the flat lookups take the time
+  P_ParallelFor(g_r_state_globals->numsectors, [data](int first, int last) {
+    auto *     ms = reinterpret_cast<mapsector_t *>(data) + first;
+    sector_t * ss = g_r_state_globals->sectors + first;
+    for (int i = first; i < last; i++, ss++, ms++) {
+      ss->floorheight   = SHORT(ms->floorheight) << FRACBITS;
+      ss->ceilingheight = SHORT(ms->ceilingheight) << FRACBITS;
+      ss->floorpic      = static_cast<short>(R_FlatNumForName(ms->floorpic));
+      ss->ceilingpic    = static_cast<short>(R_FlatNumForName(ms->ceilingpic));
+      ss->lightlevel    = SHORT(ms->lightlevel);
+      ss->special       = SHORT(ms->special);
+      ss->tag           = SHORT(ms->tag);
+      ss->thinglist     = nullptr;
+      // [crispy] WiggleFix: [kb] for R_FixWiggle()
+      ss->cachedheight = 0;
+      // [AM] Sector interpolation.  Even if we're
+      //      not running uncapped, the renderer still
+      //      uses this data.
+      ss->oldfloorheight      = ss->floorheight;
+      ss->interpfloorheight   = ss->floorheight;
+      ss->oldceilingheight    = ss->ceilingheight;
+      ss->interpceilingheight = ss->ceilingheight;
+      // [crispy] inhibit sector interpolation during the 0th gametic
+      ss->oldgametic = -1;
+    }
+  });
 
   W_ReleaseLumpNum(lump);
 }
@@ -501,27 +535,28 @@ void P_LoadLineDefs(int lump) {
 // P_LoadSideDefs
 //
 void P_LoadSideDefs(int lump) {
-  uint8_t *      data;
-  mapsidedef_t * msd;
-  side_t *       sd;
+  uint8_t * data;
 
   g_r_state_globals->numsides = static_cast<int>(W_LumpLength(lump) / sizeof(mapsidedef_t));
   g_r_state_globals->sides    = zmalloc<decltype(g_r_state_globals->sides)>(static_cast<unsigned long>(g_r_state_globals->numsides) * sizeof(side_t), PU_LEVEL, 0);
   std::memset(g_r_state_globals->sides, 0, static_cast<unsigned long>(g_r_state_globals->numsides) * sizeof(side_t));
   data = cache_lump_num<uint8_t *>(lump, PU_STATIC);
 
-  msd = reinterpret_cast<mapsidedef_t *>(data);
-  sd  = g_r_state_globals->sides;
-  for (int i = 0; i < g_r_state_globals->numsides; i++, msd++, sd++) {
-    sd->textureoffset = SHORT(msd->textureoffset) << FRACBITS;
-    sd->rowoffset     = SHORT(msd->rowoffset) << FRACBITS;
-    sd->toptexture    = static_cast<short>(R_TextureNumForName(msd->toptexture));
-    sd->bottomtexture = static_cast<short>(R_TextureNumForName(msd->bottomtexture));
-    sd->midtexture    = static_cast<short>(R_TextureNumForName(msd->midtexture));
-    sd->sector        = &g_r_state_globals->sectors[SHORT(msd->sector)];
-    // [crispy] smooth texture scrolling
-    sd->basetextureoffset = sd->textureoffset;
-  }
+  // [crispy] the texture lookups take the time
+  P_ParallelFor(g_r_state_globals->numsides, [data](int first, int last) {
+    mapsidedef_t * msd = reinterpret_cast<mapsidedef_t *>(data) + first;
+    side_t *       sd  = g_r_state_globals->sides + first;
+    for (int i = first; i < last; i++, msd++, sd++) {
+      sd->textureoffset = SHORT(msd->textureoffset) << FRACBITS;
+      sd->rowoffset     = SHORT(msd->rowoffset) << FRACBITS;
+      sd->toptexture    = static_cast<short>(R_TextureNumForName(msd->toptexture));
+      sd->bottomtexture = static_cast<short>(R_TextureNumForName(msd->bottomtexture));
+      sd->midtexture    = static_cast<short>(R_TextureNumForName(msd->midtexture));
+      sd->sector        = &g_r_state_globals->sectors[SHORT(msd->sector)];
+      // [crispy] smooth texture scrolling
+      sd->basetextureoffset = sd->textureoffset;
+    }
+  });
 
   W_ReleaseLumpNum(lump);
 }
@@ -649,6 +684,40 @@ void P_GroupLines() {
     }
   }
 
+  // Build the neighbour lists, one entry per two-sided line,
+  // so the P_Find*Surrounding functions and P_RecursiveSound
+  // don't need to look at one-sided lines at all.
+
+  int totaladj = 0;
+  for (int i = 0; i < g_r_state_globals->numsectors; ++i) {
+    sector = &g_r_state_globals->sectors[i];
+
+    for (int j = 0; j < sector->linecount; j++) {
+      if (sector->lines[j]->flags & ML_TWOSIDED)
+        totaladj++;
+    }
+  }
+
+  auto * adjbuffer = zmalloc<sectoradj_t *>(static_cast<unsigned long>(totaladj) * sizeof(sectoradj_t), PU_LEVEL, 0);
+
+  for (int i = 0; i < g_r_state_globals->numsectors; ++i) {
+    sector           = &g_r_state_globals->sectors[i];
+    sector->adjacent = adjbuffer;
+    sector->adjcount = 0;
+
+    for (int j = 0; j < sector->linecount; j++) {
+      li = sector->lines[j];
+
+      if (!(li->flags & ML_TWOSIDED))
+        continue;
+
+      adjbuffer->sector = getNextSector(li, sector);
+      adjbuffer->line   = li;
+      adjbuffer++;
+      sector->adjcount++;
+    }
+  }
+
   // Generate bounding boxes for sectors
 
   sector = g_r_state_globals->sectors;
@@ -692,6 +761,10 @@ void P_GroupLines() {
 // i.e. r_bsp.c:R_AddLine()
 
 static void P_RemoveSlimeTrails() {
+  if (P_LevelCacheSlimeTrails()) {
+    return;
+  }
+
   for (int i = 0; i < g_r_state_globals->numsegs; i++) {
     const line_t * l = g_r_state_globals->segs[i].linedef;
     vertex_t *     v = g_r_state_globals->segs[i].v1;
@@ -727,6 +800,8 @@ static void P_RemoveSlimeTrails() {
       } while ((v != g_r_state_globals->segs[i].v2) && (v = g_r_state_globals->segs[i].v2));
     }
   }
+
+  P_LevelCacheStoreSlimeTrails();
 }
 
 // Pad the REJECT lump with extra data when the lump is too small,
@@ -876,11 +951,14 @@ void P_SetupLevel(int episode, int map, int, skill_t skill) {
   // will be set by player think.
   g_doomstat_globals->players[g_doomstat_globals->consoleplayer].viewz = 1;
 
-  // [crispy] stop demo warp mode now
+  // [crispy] stop demo warp mode now,
+  // unless we are still seeking to a later tic
   if (crispy->demowarp == map) {
-    crispy->demowarp              = 0;
-    g_doomstat_globals->nodrawers = false;
-    singletics                    = false;
+    crispy->demowarp = 0;
+    if (!crispy->demoseektic) {
+      g_doomstat_globals->nodrawers = false;
+      singletics                    = false;
+    }
   }
 
   // [crispy] don't load map's default music if loaded from a savegame with MUSINFO data
@@ -894,6 +972,7 @@ void P_SetupLevel(int episode, int map, int, skill_t skill) {
 
   // UNUSED W_Profile ();
   P_InitThinkers();
+  P_InitSecNodes();
 
   // if working with a devlopment map, reload it
   W_Reload();
@@ -943,11 +1022,21 @@ void P_SetupLevel(int episode, int map, int, skill_t skill) {
 
     free(rfn_str);
   }
+  // [crispy] read the map lumps together, the loaders below find
+  // them in the cache
+  W_CacheLumpRange(lumpnum + ML_THINGS, std::clamp(static_cast<int>(numlumps) - lumpnum - ML_THINGS, 0, ML_BLOCKMAP - ML_THINGS + 1), PU_CACHE);
+
   // [crispy] check and log map and nodes format
   crispy_mapformat = P_CheckMapFormat(lumpnum);
 
   // note: most of this ordering is important
   crispy_validblockmap = P_LoadBlockMap(lumpnum + ML_BLOCKMAP); // [crispy] (re-)create BLOCKMAP if necessary
+  // [crispy] keep what is expensive to derive on disk for the next visit
+  P_LevelCacheOpen(lumpnum, !crispy_validblockmap || (crispy_mapformat & MFMT_ZDBSPZ));
+  // [crispy] inflate compressed nodes on a worker thread, they are
+  // needed only after the lines
+  if (crispy_mapformat & MFMT_ZDBSPZ)
+    P_StartNodes_ZDBSP(lumpnum + ML_NODES);
   P_LoadVertexes(lumpnum + ML_VERTEXES);
   P_LoadSectors(lumpnum + ML_SECTORS);
   P_LoadSideDefs(lumpnum + ML_SIDEDEFS);
@@ -956,10 +1045,10 @@ void P_SetupLevel(int episode, int map, int, skill_t skill) {
     P_LoadLineDefs_Hexen(lumpnum + ML_LINEDEFS);
   else
     P_LoadLineDefs(lumpnum + ML_LINEDEFS);
-  // [crispy] (re-)create BLOCKMAP if necessary
+  // [crispy] (re-)create BLOCKMAP if necessary, on a worker thread
+  // while the nodes load; P_GroupLines() is the first to need it
   if (!crispy_validblockmap) {
-    extern void P_CreateBlockMap();
-    P_CreateBlockMap();
+    P_StartCreateBlockMap();
   }
   if (crispy_mapformat & (MFMT_ZDBSPX | MFMT_ZDBSPZ))
     P_LoadNodes_ZDBSP(lumpnum + ML_NODES, crispy_mapformat & MFMT_ZDBSPZ);
@@ -973,11 +1062,16 @@ void P_SetupLevel(int episode, int map, int, skill_t skill) {
     P_LoadSegs(lumpnum + ML_SEGS);
   }
 
+  if (!crispy_validblockmap) {
+    P_FinishCreateBlockMap();
+  }
+
   P_GroupLines();
   P_LoadReject(lumpnum + ML_REJECT);
 
   // [crispy] remove slime trails
   P_RemoveSlimeTrails();
+  P_LevelCacheClose();
   // [crispy] fix long wall wobble
   P_SegLengths(false);
   // [crispy] blinking key or skull in the status bar
@@ -16,6 +16,12 @@
 //	LineOfSight/Visibility checks, uses REJECT Lookup Table.
 //
 
+#include <algorithm>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 #include "doomdef.hpp"
 #include "doomstat.hpp"
 
@@ -28,14 +34,11 @@
 //
 // P_CheckSight
 //
+// Doom 1.2 sight state for PTR_SightTraverse.
 fixed_t sightzstart; // eye z of looker
 fixed_t topslope;
 fixed_t bottomslope; // slopes to top and bottom of target
 
-divline_t strace; // from t1 to t2
-fixed_t   t2x;
-fixed_t   t2y;
-
 int sightcounts[2];
 
 // PTR_SightTraverse() for Doom 1.2 sight calculations
@@ -143,12 +146,35 @@ fixed_t
   return frac;
 }
 
+//
+// sighttrace_t
+// State of one line of sight check.  The serial P_CheckSight uses
+// a fresh one per call, the parallel precompute one per worker.
+//
+struct sighttrace_t {
+  fixed_t   sightzstart; // eye z of looker
+  fixed_t   topslope;
+  fixed_t   bottomslope; // slopes to top and bottom of target
+  divline_t strace;      // from t1 to t2
+  fixed_t   t2x;
+  fixed_t   t2y;
+
+  // Workers can't share line_t::validcount, they stamp
+  // their own copy instead.  nullptr on the game thread.
+  int * linestamps;
+  int   stamp;
+
+  // Sectors whose heights the trace has looked at,
+  // only recorded for precomputed traces.
+  std::vector<sector_t *> * touched;
+};
+
 //
 // P_CrossSubsector
 // Returns true
 //  if strace crosses the given subsector successfully.
 //
-bool P_CrossSubsector(int num) {
+bool P_CrossSubsector(int num, sighttrace_t & st) {
   seg_t *       seg;
   line_t *      line;
   int           s1;
@@ -182,15 +208,23 @@ bool P_CrossSubsector(int num) {
     line = seg->linedef;
 
     // allready checked other side?
-    if (line->validcount == validcount)
-      continue;
+    if (st.linestamps) {
+      int & mark = st.linestamps[line - g_r_state_globals->lines];
+      if (mark == st.stamp)
+        continue;
 
-    line->validcount = validcount;
+      mark = st.stamp;
+    } else {
+      if (line->validcount == validcount)
+        continue;
+
+      line->validcount = validcount;
+    }
 
     v1 = line->v1;
     v2 = line->v2;
-    s1 = P_DivlineSide(v1->x, v1->y, &strace);
-    s2 = P_DivlineSide(v2->x, v2->y, &strace);
+    s1 = P_DivlineSide(v1->x, v1->y, &st.strace);
+    s2 = P_DivlineSide(v2->x, v2->y, &st.strace);
 
     // line isn't crossed?
     if (s1 == s2)
@@ -200,8 +234,8 @@ bool P_CrossSubsector(int num) {
     divl.y  = v1->y;
     divl.dx = v2->x - v1->x;
     divl.dy = v2->y - v1->y;
-    s1      = P_DivlineSide(strace.x, strace.y, &divl);
-    s2      = P_DivlineSide(t2x, t2y, &divl);
+    s1      = P_DivlineSide(st.strace.x, st.strace.y, &divl);
+    s2      = P_DivlineSide(st.t2x, st.t2y, &divl);
 
     // line isn't crossed?
     if (s1 == s2)
@@ -223,6 +257,11 @@ bool P_CrossSubsector(int num) {
     front = seg->frontsector;
     back  = seg->backsector;
 
+    if (st.touched) {
+      st.touched->push_back(front);
+      st.touched->push_back(back);
+    }
+
     // no wall to block sight with?
     if (front->floorheight == back->floorheight
         && front->ceilingheight == back->ceilingheight)
@@ -245,21 +284,21 @@ bool P_CrossSubsector(int num) {
     if (openbottom_local >= opentop_local)
       return false; // stop
 
-    frac = P_InterceptVector2(&strace, &divl);
+    frac = P_InterceptVector2(&st.strace, &divl);
 
     if (front->floorheight != back->floorheight) {
-      slope = FixedDiv(openbottom_local - sightzstart, frac);
-      if (slope > bottomslope)
-        bottomslope = slope;
+      slope = FixedDiv(openbottom_local - st.sightzstart, frac);
+      if (slope > st.bottomslope)
+        st.bottomslope = slope;
     }
 
     if (front->ceilingheight != back->ceilingheight) {
-      slope = FixedDiv(opentop_local - sightzstart, frac);
-      if (slope < topslope)
-        topslope = slope;
+      slope = FixedDiv(opentop_local - st.sightzstart, frac);
+      if (slope < st.topslope)
+        st.topslope = slope;
     }
 
-    if (topslope <= bottomslope)
+    if (st.topslope <= st.bottomslope)
       return false; // stop
   }
   // passed the subsector ok
@@ -271,47 +310,60 @@ bool P_CrossSubsector(int num) {
 // Returns true
 //  if strace crosses the given node successfully.
 //
-bool P_CrossBSPNode(int bspnum) {
+bool P_CrossBSPNode(int bspnum, sighttrace_t & st) {
   node_t * bsp;
   int      side;
 
   if (static_cast<unsigned int>(bspnum) & NF_SUBSECTOR) {
     if (bspnum == -1)
-      return P_CrossSubsector(0);
+      return P_CrossSubsector(0, st);
     else
-      return P_CrossSubsector(static_cast<unsigned int>(bspnum) & (~NF_SUBSECTOR));
+      return P_CrossSubsector(static_cast<unsigned int>(bspnum) & (~NF_SUBSECTOR), st);
   }
 
   bsp = &g_r_state_globals->nodes[bspnum];
 
   // decide which side the start point is on
-  side = P_DivlineSide(strace.x, strace.y, reinterpret_cast<divline_t *>(bsp));
+  side = P_DivlineSide(st.strace.x, st.strace.y, reinterpret_cast<divline_t *>(bsp));
   if (side == 2)
     side = 0; // an "on" should cross both sides
 
   // cross the starting side
-  if (!P_CrossBSPNode(bsp->children[side]))
+  if (!P_CrossBSPNode(bsp->children[side], st))
     return false;
 
   // the partition plane is crossed here
-  if (side == P_DivlineSide(t2x, t2y, reinterpret_cast<divline_t *>(bsp))) {
+  if (side == P_DivlineSide(st.t2x, st.t2y, reinterpret_cast<divline_t *>(bsp))) {
     // the line doesn't touch the other side
     return true;
   }
 
   // cross the ending side
-  return P_CrossBSPNode(bsp->children[side ^ 1]);
+  return P_CrossBSPNode(bsp->children[side ^ 1], st);
 }
 
 //
-// P_CheckSight
-// Returns true
-//  if a straight line between t1 and t2 is unobstructed.
-// Uses REJECT.
+// P_StartSightTrace
+// Sets up the slopes and divline from the eyes of t1 to t2.
 //
-bool P_CheckSight(mobj_t * t1,
-                  mobj_t * t2) {
-  // First check for trivial rejection.
+static void P_StartSightTrace(sighttrace_t & st, mobj_t * t1, mobj_t * t2) {
+  st.sightzstart = t1->z + t1->height - (t1->height >> 2);
+  st.topslope    = (t2->z + t2->height) - st.sightzstart;
+  st.bottomslope = (t2->z) - st.sightzstart;
+
+  st.strace.x  = t1->x;
+  st.strace.y  = t1->y;
+  st.t2x       = t2->x;
+  st.t2y       = t2->y;
+  st.strace.dx = t2->x - t1->x;
+  st.strace.dy = t2->y - t1->y;
+}
+
+//
+// P_RejectSight
+// Returns true if REJECT says t1 can't possibly see t2.
+//
+static bool P_RejectSight(mobj_t * t1, mobj_t * t2) {
   // Determine subsector entries in REJECT table.
   int s1      = static_cast<int>(t1->subsector->sector - g_r_state_globals->sectors);
   int s2      = static_cast<int>(t2->subsector->sector - g_r_state_globals->sectors);
@@ -319,8 +371,210 @@ bool P_CheckSight(mobj_t * t1,
   int bytenum = pnum >> 3;
   int bitnum  = 1 << (pnum & 7);
 
+  return g_p_local_globals->rejectmatrix[bytenum] & bitnum;
+}
+
+//
+// SIGHT PRECOMPUTE
+// With -parallelai, the sight checks the monster AI is about to
+// ask for are traced on worker threads before the thinkers run.
+// The thinkers still call P_CheckSight serially in thinker order;
+// a precomputed result is only used while both mobjs and every
+// sector height the trace looked at are unchanged, so the answer
+// (and with it every P_Random call that follows) is identical.
+//
+struct sightpos_t {
+  fixed_t       x;
+  fixed_t       y;
+  fixed_t       z;
+  fixed_t       height;
+  subsector_t * subsector;
+
+  explicit sightpos_t(const mobj_t * mo)
+      : x(mo->x)
+      , y(mo->y)
+      , z(mo->z)
+      , height(mo->height)
+      , subsector(mo->subsector) {
+  }
+
+  bool operator==(const sightpos_t &) const = default;
+};
+
+struct sightentry_t {
+  mobj_t *   t1;
+  mobj_t *   t2;
+  sightpos_t pos1;
+  sightpos_t pos2;
+  bool       rejected; // trivial REJECT result, no trace made
+  bool       result;
+
+  // sectors the trace looked at, with their heightgen at the time
+  std::vector<std::pair<sector_t *, int>> sectors;
+};
+
+struct sightpairhash_t {
+  size_t operator()(const std::pair<const mobj_t *, const mobj_t *> & p) const {
+    return std::hash<const mobj_t *>()(p.first) * 31 + std::hash<const mobj_t *>()(p.second);
+  }
+};
+
+static std::vector<sightentry_t> sightentries;
+static std::unordered_map<std::pair<const mobj_t *, const mobj_t *>, size_t, sightpairhash_t> sightindex;
+static bool sightcacheactive;
+
+// Don't bother spinning up workers for a handful of traces.
+constexpr auto MINPARALLELSIGHT = 32;
+
+static void P_AddSightPair(mobj_t * t1, mobj_t * t2) {
+  if (!t2 || t2 == t1 || !t2->subsector)
+    return;
+
+  if (!sightindex.try_emplace({ t1, t2 }, sightentries.size()).second)
+    return;
+
+  sightentries.push_back({ t1, t2, sightpos_t(t1), sightpos_t(t2), false, false, {} });
+}
+
+static void P_TraceSightEntries(size_t first, size_t last) {
+  std::vector<int>        linestamps(static_cast<size_t>(g_r_state_globals->numlines), 0);
+  std::vector<sector_t *> touched;
+  sighttrace_t            st {};
+
+  st.linestamps = linestamps.data();
+  st.touched    = &touched;
+
+  for (size_t i = first; i < last; i++) {
+    sightentry_t & e = sightentries[i];
+
+    if (P_RejectSight(e.t1, e.t2)) {
+      e.rejected = true;
+      e.result   = false;
+      continue;
+    }
+
+    touched.clear();
+    st.stamp++;
+    P_StartSightTrace(st, e.t1, e.t2);
+    e.result = P_CrossBSPNode(g_r_state_globals->numnodes - 1, st);
+
+    std::sort(touched.begin(), touched.end());
+    touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+    for (sector_t * sec : touched)
+      e.sectors.emplace_back(sec, sec->heightgen);
+  }
+}
+
+//
+// P_PrecomputeSight
+// Called at the start of a tic, before any thinker runs.
+//
+void P_PrecomputeSight() {
+  sightentries.clear();
+  sightindex.clear();
+  sightcacheactive = false;
+
+  // Doom 1.2 sight goes through P_PathTraverse, which isn't reentrant.
+  if (g_doomstat_globals->gameversion <= exe_doom_1_2)
+    return;
+
+  action_hook needle = P_MobjThinker;
+  for (thinker_t * th = g_p_local_globals->thinkercap.next; th != &g_p_local_globals->thinkercap; th = th->next) {
+    if (th->function != needle)
+      continue;
+
+    auto * mo = reinterpret_cast<mobj_t *>(th);
+
+    // only living monsters look around
+    if (mo->player || mo->health <= 0 || !(mo->flags & MF_SHOOTABLE)
+        || mo->info->seestate == S_NULL)
+      continue;
+
+    // A_Chase and the range checks
+    P_AddSightPair(mo, mo->target);
+
+    // A_Look on ambush
+    P_AddSightPair(mo, mo->subsector->sector->soundtarget);
+
+    // P_LookForPlayers
+    for (int i = 0; i < MAXPLAYERS; i++) {
+      if (g_doomstat_globals->playeringame[i] && g_doomstat_globals->players[i].health > 0)
+        P_AddSightPair(mo, g_doomstat_globals->players[i].mo);
+    }
+  }
+
+  if (sightentries.size() < MINPARALLELSIGHT)
+    return;
+
+  size_t numworkers = std::max(1u, std::thread::hardware_concurrency());
+  size_t chunk      = (sightentries.size() + numworkers - 1) / numworkers;
+
+  std::vector<std::thread> workers;
+  for (size_t first = chunk; first < sightentries.size(); first += chunk)
+    workers.emplace_back(P_TraceSightEntries, first, std::min(first + chunk, sightentries.size()));
+
+  // the game thread takes the first chunk itself
+  P_TraceSightEntries(0, std::min(chunk, sightentries.size()));
+
+  for (auto & worker : workers)
+    worker.join();
+
+  sightcacheactive = true;
+}
+
+//
+// P_ClearPrecomputedSight
+// Called when the thinkers are done with the tic.
+//
+void P_ClearPrecomputedSight() {
+  sightcacheactive = false;
+}
+
+//
+// P_LookupSight
+// Returns the precomputed entry for t1 -> t2 if it still holds.
+//
+static const sightentry_t * P_LookupSight(mobj_t * t1, mobj_t * t2) {
+  auto it = sightindex.find({ t1, t2 });
+  if (it == sightindex.end())
+    return nullptr;
+
+  const sightentry_t & e = sightentries[it->second];
+  if (e.pos1 != sightpos_t(t1) || e.pos2 != sightpos_t(t2))
+    return nullptr;
+
+  for (const auto & [sec, heightgen] : e.sectors) {
+    if (sec->heightgen != heightgen)
+      return nullptr;
+  }
+
+  return &e;
+}
+
+//
+// P_CheckSight
+// Returns true
+//  if a straight line between t1 and t2 is unobstructed.
+// Uses REJECT.
+//
+bool P_CheckSight(mobj_t * t1,
+                  mobj_t * t2) {
+  if (sightcacheactive) {
+    if (const sightentry_t * e = P_LookupSight(t1, t2)) {
+      // keep the same side effects as the traced check
+      if (e->rejected) {
+        sightcounts[0]++;
+      } else {
+        sightcounts[1]++;
+        validcount++;
+      }
+      return e->result;
+    }
+  }
+
+  // First check for trivial rejection.
   // Check in REJECT table.
-  if (g_p_local_globals->rejectmatrix[bytenum] & bitnum) {
+  if (P_RejectSight(t1, t2)) {
     sightcounts[0]++;
 
     // can't possibly be connected
@@ -333,21 +587,17 @@ bool P_CheckSight(mobj_t * t1,
 
   validcount++;
 
-  sightzstart = t1->z + t1->height - (t1->height >> 2);
-  topslope    = (t2->z + t2->height) - sightzstart;
-  bottomslope = (t2->z) - sightzstart;
-
   if (g_doomstat_globals->gameversion <= exe_doom_1_2) {
+    sightzstart = t1->z + t1->height - (t1->height >> 2);
+    topslope    = (t2->z + t2->height) - sightzstart;
+    bottomslope = (t2->z) - sightzstart;
+
     return P_PathTraverse(t1->x, t1->y, t2->x, t2->y, PT_EARLYOUT | PT_ADDLINES, PTR_SightTraverse);
   }
 
-  strace.x  = t1->x;
-  strace.y  = t1->y;
-  t2x       = t2->x;
-  t2y       = t2->y;
-  strace.dx = t2->x - t1->x;
-  strace.dy = t2->y - t1->y;
+  sighttrace_t st {};
+  P_StartSightTrace(st, t1, t2);
 
   // the head node is the last node output
-  return P_CrossBSPNode(g_r_state_globals->numnodes - 1);
+  return P_CrossBSPNode(g_r_state_globals->numnodes - 1, st);
 }
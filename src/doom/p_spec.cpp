@@ -20,6 +20,10 @@
 //	Line Tag handling. Line and Sector triggers.
 //
 
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
 #include <fmt/printf.h>
 
 #include "deh_main.hpp"
@@ -271,13 +275,11 @@ sector_t *
 // FIND LOWEST FLOOR HEIGHT IN SURROUNDING SECTORS
 //
 fixed_t P_FindLowestFloorSurrounding(sector_t * sec) {
-  line_t *   check;
   sector_t * other;
   fixed_t    floor = sec->floorheight;
 
-  for (int i = 0; i < sec->linecount; i++) {
-    check = sec->lines[i];
-    other = getNextSector(check, sec);
+  for (int i = 0; i < sec->adjcount; i++) {
+    other = sec->adjacent[i].sector;
 
     if (!other)
       continue;
@@ -293,13 +295,11 @@ fixed_t P_FindLowestFloorSurrounding(sector_t * sec) {
 // FIND HIGHEST FLOOR HEIGHT IN SURROUNDING SECTORS
 //
 fixed_t P_FindHighestFloorSurrounding(sector_t * sec) {
-  line_t *   check;
   sector_t * other;
   fixed_t    floor = -500 * FRACUNIT;
 
-  for (int i = 0; i < sec->linecount; i++) {
-    check = sec->lines[i];
-    other = getNextSector(check, sec);
+  for (int i = 0; i < sec->adjcount; i++) {
+    other = sec->adjacent[i].sector;
 
     if (!other)
       continue;
@@ -326,7 +326,6 @@ fixed_t
   int              i;
   int              h;
   int              min;
-  line_t *         check;
   sector_t *       other;
   fixed_t          height          = currentheight;
   static fixed_t * heightlist      = nullptr;
@@ -341,9 +340,8 @@ fixed_t
     heightlist = static_cast<decltype(heightlist)>(I_Realloc(heightlist, static_cast<unsigned long>(heightlist_size) * sizeof(*heightlist)));
   }
 
-  for (i = 0, h = 0; i < sec->linecount; i++) {
-    check = sec->lines[i];
-    other = getNextSector(check, sec);
+  for (i = 0, h = 0; i < sec->adjcount; i++) {
+    other = sec->adjacent[i].sector;
 
     if (!other)
       continue;
@@ -384,13 +382,11 @@ fixed_t
 //
 fixed_t
     P_FindLowestCeilingSurrounding(sector_t * sec) {
-  line_t *   check;
   sector_t * other;
   fixed_t    height = std::numeric_limits<int32_t>::max();
 
-  for (int i = 0; i < sec->linecount; i++) {
-    check = sec->lines[i];
-    other = getNextSector(check, sec);
+  for (int i = 0; i < sec->adjcount; i++) {
+    other = sec->adjacent[i].sector;
 
     if (!other)
       continue;
@@ -405,13 +401,11 @@ fixed_t
 // FIND HIGHEST CEILING IN THE SURROUNDING SECTORS
 //
 fixed_t P_FindHighestCeilingSurrounding(sector_t * sec) {
-  line_t *   check;
   sector_t * other;
   fixed_t    height = 0;
 
-  for (int i = 0; i < sec->linecount; i++) {
-    check = sec->lines[i];
-    other = getNextSector(check, sec);
+  for (int i = 0; i < sec->adjcount; i++) {
+    other = sec->adjacent[i].sector;
 
     if (!other)
       continue;
@@ -422,13 +416,40 @@ fixed_t P_FindHighestCeilingSurrounding(sector_t * sec) {
   return height;
 }
 
+//
+// TAG INDEX
+// Sector numbers by tag, in ascending order, so the
+// line triggers only visit the sectors they act on.
+//
+static std::unordered_map<int, std::vector<int>> sectortags;
+
+void P_InitTagLists() {
+  sectortags.clear();
+
+  for (int i = 0; i < g_r_state_globals->numsectors; i++)
+    sectortags[g_r_state_globals->sectors[i].tag].push_back(i);
+}
+
+//
+// RETURN NEXT SECTOR # WITH THE GIVEN TAG AFTER start
+//
+int P_FindSectorFromTag(int tag,
+                        int start) {
+  auto it = sectortags.find(tag);
+  if (it == sectortags.end())
+    return -1;
+
+  const std::vector<int> & secnums = it->second;
+  auto                     next    = std::upper_bound(secnums.begin(), secnums.end(), start);
+
+  return next == secnums.end() ? -1 : *next;
+}
+
 //
 // RETURN NEXT SECTOR # THAT LINE TAG REFERS TO
 //
 int P_FindSectorFromLineTag(line_t * line,
                             int      start) {
-  int i;
-
 #if 0
     // [crispy] linedefs without tags apply locally
     if (crispy->singleplayer && !line->tag)
@@ -450,11 +471,7 @@ int P_FindSectorFromLineTag(line_t * line,
   }
 #endif
 
-  for (i = start + 1; i < g_r_state_globals->numsectors; i++)
-    if (g_r_state_globals->sectors[i].tag == line->tag)
-      return i;
-
-  return -1;
+  return P_FindSectorFromTag(line->tag, start);
 }
 
 //
@@ -463,13 +480,11 @@ int P_FindSectorFromLineTag(line_t * line,
 int P_FindMinSurroundingLight(sector_t * sector,
                               int        max) {
   int        min;
-  line_t *   line;
   sector_t * check;
 
   min = max;
-  for (int i = 0; i < sector->linecount; i++) {
-    line  = sector->lines[i];
-    check = getNextSector(line, sector);
+  for (int i = 0; i < sector->adjcount; i++) {
+    check = sector->adjacent[i].sector;
 
     if (!check)
       continue;
@@ -1402,6 +1417,8 @@ static unsigned int NumScrollers() {
 void P_SpawnSpecials() {
   sector_t * sector;
 
+  P_InitTagLists();
+
   // See if -TIMER was specified.
 
   if (g_doomstat_globals->timelimit > 0 && g_doomstat_globals->deathmatch) {
@@ -1493,12 +1510,10 @@ void P_SpawnSpecials() {
     // [crispy] add support for MBF sky tranfers
     case 271:
     case 272: {
-      int secnum;
+      int secnum = -1;
 
-      for (secnum = 0; secnum < g_r_state_globals->numsectors; secnum++) {
-        if (g_r_state_globals->sectors[secnum].tag == g_r_state_globals->lines[i].tag) {
-          g_r_state_globals->sectors[secnum].sky = static_cast<int>(static_cast<unsigned int>(i) | PL_SKYFLAT);
-        }
+      while ((secnum = P_FindSectorFromTag(g_r_state_globals->lines[i].tag, secnum)) >= 0) {
+        g_r_state_globals->sectors[secnum].sky = static_cast<int>(static_cast<unsigned int>(i) | PL_SKYFLAT);
       }
     } break;
     }
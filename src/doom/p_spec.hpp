@@ -81,6 +81,11 @@ fixed_t
 fixed_t P_FindLowestCeilingSurrounding(sector_t * sec);
 fixed_t P_FindHighestCeilingSurrounding(sector_t * sec);
 
+void P_InitTagLists();
+
+int P_FindSectorFromTag(int tag,
+                        int start);
+
 int P_FindSectorFromLineTag(line_t * line,
                             int      start);
 
@@ -141,6 +146,7 @@ constexpr auto FASTDARK     = 15;
 constexpr auto SLOWDARK     = 35;
 
 void P_SpawnFireFlicker(sector_t * sector);
+void T_FireFlicker(fireflicker_t * flick);
 void T_LightFlash(lightflash_t * flash);
 void P_SpawnLightFlash(sector_t * sector);
 void T_StrobeFlash(strobe_t * flash);
@@ -55,66 +55,65 @@ int EV_Teleport(line_t * line,
     return 0;
 
   tag = line->tag;
-  for (int i = 0; i < g_r_state_globals->numsectors; i++) {
-    if (g_r_state_globals->sectors[i].tag == tag) {
-      thinker = g_p_local_globals->thinkercap.next;
-      for (thinker = g_p_local_globals->thinkercap.next;
-           thinker != &g_p_local_globals->thinkercap;
-           thinker = thinker->next) {
-        // not a mobj
-        action_hook needle = P_MobjThinker;
-        if (thinker->function != needle)
-          continue;
-
-        m = reinterpret_cast<mobj_t *>(thinker);
-
-        // not a teleportman
-        if (m->type != MT_TELEPORTMAN)
-          continue;
-
-        sector = m->subsector->sector;
-        // wrong sector
-        if (sector - g_r_state_globals->sectors != i)
-          continue;
-
-        oldx = thing->x;
-        oldy = thing->y;
-        oldz = thing->z;
-
-        if (!P_TeleportMove(thing, m->x, m->y))
-          return 0;
-
-        // The first Final Doom executable does not set thing->z
-        // when teleporting. This quirk is unique to this
-        // particular version; the later version included in
-        // some versions of the Id Anthology fixed this.
-
-        if (g_doomstat_globals->gameversion != exe_final)
-          thing->z = thing->floorz;
-
-        if (thing->player) {
-          thing->player->viewz = thing->z + thing->player->viewheight;
-          // [crispy] center view after teleporting
-          thing->player->centering = true;
-        }
-
-        // spawn teleport fog at source and destination
-        fog = P_SpawnMobj(oldx, oldy, oldz, MT_TFOG);
-        S_StartSound(fog, sfx_telept);
-        an  = m->angle >> ANGLETOFINESHIFT;
-        fog = P_SpawnMobj(m->x + 20 * finecosine[an], m->y + 20 * finesine[an], thing->z, MT_TFOG);
-
-        // emit sound, where?
-        S_StartSound(fog, sfx_telept);
-
-        // don't move for a bit
-        if (thing->player)
-          thing->reactiontime = 18;
-
-        thing->angle = m->angle;
-        thing->momx = thing->momy = thing->momz = 0;
-        return 1;
+  int i = -1;
+  while ((i = P_FindSectorFromTag(tag, i)) >= 0) {
+    thinker = g_p_local_globals->thinkercap.next;
+    for (thinker = g_p_local_globals->thinkercap.next;
+         thinker != &g_p_local_globals->thinkercap;
+         thinker = thinker->next) {
+      // not a mobj
+      action_hook needle = P_MobjThinker;
+      if (thinker->function != needle)
+        continue;
+
+      m = reinterpret_cast<mobj_t *>(thinker);
+
+      // not a teleportman
+      if (m->type != MT_TELEPORTMAN)
+        continue;
+
+      sector = m->subsector->sector;
+      // wrong sector
+      if (sector - g_r_state_globals->sectors != i)
+        continue;
+
+      oldx = thing->x;
+      oldy = thing->y;
+      oldz = thing->z;
+
+      if (!P_TeleportMove(thing, m->x, m->y))
+        return 0;
+
+      // The first Final Doom executable does not set thing->z
+      // when teleporting. This quirk is unique to this
+      // particular version; the later version included in
+      // some versions of the Id Anthology fixed this.
+
+      if (g_doomstat_globals->gameversion != exe_final)
+        thing->z = thing->floorz;
+
+      if (thing->player) {
+        thing->player->viewz = thing->z + thing->player->viewheight;
+        // [crispy] center view after teleporting
+        thing->player->centering = true;
       }
+
+      // spawn teleport fog at source and destination
+      fog = P_SpawnMobj(oldx, oldy, oldz, MT_TFOG);
+      S_StartSound(fog, sfx_telept);
+      an  = m->angle >> ANGLETOFINESHIFT;
+      fog = P_SpawnMobj(m->x + 20 * finecosine[an], m->y + 20 * finesine[an], thing->z, MT_TFOG);
+
+      // emit sound, where?
+      S_StartSound(fog, sfx_telept);
+
+      // don't move for a bit
+      if (thing->player)
+        thing->reactiontime = 18;
+
+      thing->angle = m->angle;
+      thing->momx = thing->momy = thing->momz = 0;
+      return 1;
     }
   }
   return 0;
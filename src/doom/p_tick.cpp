@@ -17,7 +17,9 @@
 //	Thinker, Ticker.
 //
 
+#include "m_profile.hpp"
 #include "p_local.hpp"
+#include "p_tick.hpp"
 #include "s_musinfo.hpp" // [crispy] T_MAPMusic()
 #include "z_zone.hpp"
 
@@ -98,6 +100,8 @@ void P_RunThinkers() {
 //
 
 void P_Ticker() {
+  PROFILE_ZONE("P_Ticker");
+
   // run the tic
   if (g_doomstat_globals->paused)
     return;
@@ -114,10 +118,70 @@ void P_Ticker() {
     if (g_doomstat_globals->playeringame[i])
       P_PlayerThink(&g_doomstat_globals->players[i]);
 
+  // precomputed sight is exact, but keep recordings on the plain path
+  bool parallelai = g_doomstat_globals->parallelai && !g_doomstat_globals->demorecording;
+
+  if (parallelai)
+    P_PrecomputeSight();
+
   P_RunThinkers();
+
+  if (parallelai)
+    P_ClearPrecomputedSight();
+
   P_UpdateSpecials();
   P_RespawnSpecials();
 
   // for par times
   leveltime++;
 }
+
+//
+// P_StateHash
+// [crispy] Hash everything the playsim outcome depends on most directly:
+// the RNG index, sector heights and every mobj's position, motion,
+// health and state. Two runs of the same demo that produce different
+// hashes for a tic have desynced at or before that tic.
+//
+static inline void P_HashValue(uint64_t & hash, int value) {
+  // FNV-1a, one 32-bit value at a time
+  hash = (hash ^ static_cast<uint32_t>(value)) * 0x100000001b3ULL;
+}
+
+uint64_t P_StateHash() {
+  extern int prndindex;
+  uint64_t   hash = 0xcbf29ce484222325ULL;
+
+  P_HashValue(hash, leveltime);
+  P_HashValue(hash, prndindex);
+
+  for (int i = 0; i < g_r_state_globals->numsectors; i++) {
+    const sector_t * sec = &g_r_state_globals->sectors[i];
+
+    P_HashValue(hash, sec->floorheight);
+    P_HashValue(hash, sec->ceilingheight);
+  }
+
+  action_hook needle = P_MobjThinker;
+  for (thinker_t * th = g_p_local_globals->thinkercap.next; th != &g_p_local_globals->thinkercap; th = th->next) {
+    if (th->function != needle)
+      continue;
+
+    const auto * mo = reinterpret_cast<mobj_t *>(th);
+
+    P_HashValue(hash, mo->type);
+    P_HashValue(hash, mo->x);
+    P_HashValue(hash, mo->y);
+    P_HashValue(hash, mo->z);
+    P_HashValue(hash, mo->momx);
+    P_HashValue(hash, mo->momy);
+    P_HashValue(hash, mo->momz);
+    P_HashValue(hash, static_cast<int>(mo->angle));
+    P_HashValue(hash, mo->health);
+    P_HashValue(hash, static_cast<int>(mo->flags));
+    P_HashValue(hash, mo->tics);
+    P_HashValue(hash, mo->state ? static_cast<int>(mo->state - states) : -1);
+  }
+
+  return hash;
+}
@@ -18,7 +18,12 @@
 
 #pragma once
 
+#include <cstdint>
+
 // Called by C_Ticker,
 // can call G_PlayerExited.
 // Carries out all thinking of monsters and players.
 void P_Ticker();
+
+// [crispy] 64-bit hash of the playsim state
+uint64_t P_StateHash();
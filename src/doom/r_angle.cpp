@@ -0,0 +1,246 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	[crispy] View angle math of r_main.cpp, with the view point
+//	passed in, so the tests can check the batch against the scalar
+//	functions.
+//
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "r_angle.hpp"
+
+// [crispy] R_PointToAngleSlope() of the delta from the view point,
+// called with either slope_div = SlopeDivCrispy() or SlopeDiv()
+angle_t
+    R_DeltaToAngleSlope(fixed_t x,
+                        fixed_t y,
+                        int (*slope_div)(unsigned int num, unsigned int den)) {
+  if ((!x) && (!y))
+    return 0;
+
+  // [crispy] negating INT_MIN wraps around, as it did in vanilla,
+  // instead of being undefined
+  auto negate = [](fixed_t value) { return static_cast<fixed_t>(0u - static_cast<unsigned int>(value)); };
+
+  if (x >= 0) {
+    // x >=0
+    if (y >= 0) {
+      // y>= 0
+
+      if (x > y) {
+        // octant 0
+        return tantoangle[slope_div(static_cast<unsigned int>(y), static_cast<unsigned int>(x))];
+      } else {
+        // octant 1
+        return ANG90 - 1 - tantoangle[slope_div(static_cast<unsigned int>(x), static_cast<unsigned int>(y))];
+      }
+    } else {
+      // y<0
+      y = negate(y);
+
+      if (x > y) {
+        // octant 8
+        // Subtracting from 0u avoids compiler warnings
+        return 0u - tantoangle[slope_div(static_cast<unsigned int>(y), static_cast<unsigned int>(x))];
+      } else {
+        // octant 7
+        return ANG270 + tantoangle[slope_div(static_cast<unsigned int>(x), static_cast<unsigned int>(y))];
+      }
+    }
+  } else {
+    // x<0
+    x = negate(x);
+
+    if (y >= 0) {
+      // y>= 0
+      if (x > y) {
+        // octant 3
+        return ANG180 - 1 - tantoangle[slope_div(static_cast<unsigned int>(y), static_cast<unsigned int>(x))];
+      } else {
+        // octant 2
+        return ANG90 + tantoangle[slope_div(static_cast<unsigned int>(x), static_cast<unsigned int>(y))];
+      }
+    } else {
+      // y<0
+      y = negate(y);
+
+      if (x > y) {
+        // octant 4
+        return ANG180 + tantoangle[slope_div(static_cast<unsigned int>(y), static_cast<unsigned int>(x))];
+      } else {
+        // octant 5
+        return ANG270 - 1 - tantoangle[slope_div(static_cast<unsigned int>(x), static_cast<unsigned int>(y))];
+      }
+    }
+  }
+  [[unreachable]];
+}
+
+// [crispy] overflow-safe R_PointToAngle() flavor
+angle_t
+    R_PointToAngleCrispyAt(fixed_t viewx,
+                           fixed_t viewy,
+                           fixed_t x,
+                           fixed_t y) {
+  // [crispy] fix overflows for very long distances
+  int64_t y_viewy = static_cast<int64_t>(y) - viewy;
+  int64_t x_viewx = static_cast<int64_t>(x) - viewx;
+
+  // [crispy] the worst that could happen is e.g. std::numeric_limits<int32_t>::min()-std::numeric_limits<int32_t>::max() = 2*std::numeric_limits<int32_t>::min()
+  if (x_viewx < std::numeric_limits<int32_t>::min() || x_viewx > std::numeric_limits<int32_t>::max() || y_viewy < std::numeric_limits<int32_t>::min() || y_viewy > std::numeric_limits<int32_t>::max()) {
+    // [crispy] preserving the angle by halfing the distance in both directions
+    x = static_cast<fixed_t>(x_viewx / 2 + viewx);
+    y = static_cast<fixed_t>(y_viewy / 2 + viewy);
+  }
+
+  return R_DeltaToAngleSlope(x - viewx, y - viewy, SlopeDivCrispy);
+}
+
+//
+// [crispy] R_PointToAngleBatchAt
+// R_PointToAngleCrispyAt() for an array of points. The octant and the
+// SlopeDivCrispy() quotient are computed four points at a time; the
+// tantoangle[] lookup stays, so every angle is exactly the same as
+// from the scalar function.
+//
+
+// indexed by (x < 0) << 2 | (y < 0) << 1 | !(|x| > |y|),
+// the angle is base + tantoangle[] or base - tantoangle[]
+static const angle_t octant_base[8] = {
+  0, ANG90 - 1, 0, ANG270, ANG180 - 1, ANG90, ANG180, ANG270 - 1
+};
+static const bool octant_negate[8] = {
+  false, true, true, false, true, false, false, true
+};
+
+static inline int R_Octant(fixed_t dx, fixed_t dy) {
+  // negating INT_MIN wraps, as in R_DeltaToAngleSlope()
+  const int ax = static_cast<int>(dx < 0 ? 0u - static_cast<unsigned int>(dx) : static_cast<unsigned int>(dx));
+  const int ay = static_cast<int>(dy < 0 ? 0u - static_cast<unsigned int>(dy) : static_cast<unsigned int>(dy));
+
+  return (dx < 0) << 2 | (dy < 0) << 1 | !(ax > ay);
+}
+
+static inline angle_t R_OctantAngle(int octant, int slope) {
+  return octant_negate[octant] ? octant_base[octant] - tantoangle[slope] : octant_base[octant] + tantoangle[slope];
+}
+
+static angle_t R_DeltaToAngleCrispy(fixed_t dx, fixed_t dy) {
+  if (!dx && !dy)
+    return 0;
+
+  const int          octant = R_Octant(dx, dy);
+  const unsigned int ax     = dx < 0 ? 0u - static_cast<unsigned int>(dx) : static_cast<unsigned int>(dx);
+  const unsigned int ay     = dy < 0 ? 0u - static_cast<unsigned int>(dy) : static_cast<unsigned int>(dy);
+
+  return R_OctantAngle(octant, (octant & 1) ? SlopeDivCrispy(ax, ay) : SlopeDivCrispy(ay, ax));
+}
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+
+// Octants and slopes of four deltas. The quotient of SlopeDivCrispy()
+// is at most 2^35 / 2 and is computed exactly in double precision.
+static inline void R_DeltasToSlopes4(const fixed_t * dx, const fixed_t * dy, int * octant, int * slope) {
+  const __m128i x     = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dx));
+  const __m128i y     = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dy));
+  const __m128i x_neg = _mm_srai_epi32(x, 31);
+  const __m128i y_neg = _mm_srai_epi32(y, 31);
+  const __m128i ax    = _mm_sub_epi32(_mm_xor_si128(x, x_neg), x_neg);
+  const __m128i ay    = _mm_sub_epi32(_mm_xor_si128(y, y_neg), y_neg);
+
+  // signed comparison of the wrapped absolute values
+  const __m128i x_major = _mm_cmpgt_epi32(ax, ay);
+
+  const __m128i num = _mm_or_si128(_mm_and_si128(x_major, ay), _mm_andnot_si128(x_major, ax));
+  const __m128i den = _mm_or_si128(_mm_and_si128(x_major, ax), _mm_andnot_si128(x_major, ay));
+
+  const __m128i oct = _mm_or_si128(_mm_or_si128(_mm_and_si128(x_neg, _mm_set1_epi32(4)), _mm_and_si128(y_neg, _mm_set1_epi32(2))),
+                                   _mm_andnot_si128(x_major, _mm_set1_epi32(1)));
+
+  // den < 512 (unsigned)
+  const __m128i small = _mm_cmpeq_epi32(_mm_srli_epi32(den, 9), _mm_setzero_si128());
+
+  // num << 3 as an unsigned value, from its upper 31 bits and lowest bit
+  const __m128i num_high = _mm_srli_epi32(num, 1);
+  const __m128i num_low  = _mm_and_si128(num, _mm_set1_epi32(1));
+  const __m128i den_high = _mm_srli_epi32(den, 8);
+  const __m128d clamp    = _mm_set1_pd(SLOPERANGE);
+
+  __m128d q_low = _mm_add_pd(_mm_mul_pd(_mm_cvtepi32_pd(num_high), _mm_set1_pd(16.0)), _mm_mul_pd(_mm_cvtepi32_pd(num_low), _mm_set1_pd(8.0)));
+  __m128d q_high = _mm_add_pd(_mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(num_high, 8)), _mm_set1_pd(16.0)),
+                              _mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(num_low, 8)), _mm_set1_pd(8.0)));
+
+  // a NaN or infinite quotient only occurs for den < 512 and becomes SLOPERANGE
+  q_low  = _mm_min_pd(_mm_div_pd(q_low, _mm_cvtepi32_pd(den_high)), clamp);
+  q_high = _mm_min_pd(_mm_div_pd(q_high, _mm_cvtepi32_pd(_mm_srli_si128(den_high, 8))), clamp);
+
+  __m128i s = _mm_unpacklo_epi64(_mm_cvttpd_epi32(q_low), _mm_cvttpd_epi32(q_high));
+  s         = _mm_or_si128(_mm_and_si128(small, _mm_set1_epi32(SLOPERANGE)), _mm_andnot_si128(small, s));
+
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(octant), oct);
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(slope), s);
+}
+
+#define R_DELTASTOSLOPES4
+#endif
+
+static void R_DeltasToAnglesCrispy(angle_t * out, const fixed_t * dx, const fixed_t * dy, int count) {
+  int i = 0;
+
+#ifdef R_DELTASTOSLOPES4
+  for (; i + 4 <= count; i += 4) {
+    int octant[4], slope[4];
+
+    R_DeltasToSlopes4(dx + i, dy + i, octant, slope);
+
+    for (int j = 0; j < 4; j++) {
+      out[i + j] = (!dx[i + j] && !dy[i + j]) ? 0 : R_OctantAngle(octant[j], slope[j]);
+    }
+  }
+#endif
+
+  for (; i < count; i++) {
+    out[i] = R_DeltaToAngleCrispy(dx[i], dy[i]);
+  }
+}
+
+void R_PointToAngleBatchAt(fixed_t viewx, fixed_t viewy, angle_t * out, const fixed_t * x, const fixed_t * y, int count) {
+  static std::vector<fixed_t> dx, dy;
+
+  if (dx.size() < static_cast<size_t>(count)) {
+    dx.resize(static_cast<size_t>(count));
+    dy.resize(static_cast<size_t>(count));
+  }
+
+  // the distance halving of R_PointToAngleCrispy()
+  for (int i = 0; i < count; i++) {
+    const int64_t x_viewx = static_cast<int64_t>(x[i]) - viewx;
+    const int64_t y_viewy = static_cast<int64_t>(y[i]) - viewy;
+
+    if (x_viewx < std::numeric_limits<int32_t>::min() || x_viewx > std::numeric_limits<int32_t>::max() || y_viewy < std::numeric_limits<int32_t>::min() || y_viewy > std::numeric_limits<int32_t>::max()) {
+      dx[i] = static_cast<fixed_t>(x_viewx / 2);
+      dy[i] = static_cast<fixed_t>(y_viewy / 2);
+    } else {
+      dx[i] = static_cast<fixed_t>(x_viewx);
+      dy[i] = static_cast<fixed_t>(y_viewy);
+    }
+  }
+
+  R_DeltasToAnglesCrispy(out, dx.data(), dy.data(), count);
+}
@@ -0,0 +1,29 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	[crispy] View angle math of r_main.cpp, with the view point
+//	passed in, so the tests can check the batch against the scalar
+//	functions.
+//
+
+#pragma once
+
+#include "tables.hpp"
+
+angle_t R_DeltaToAngleSlope(fixed_t x, fixed_t y, int (*slope_div)(unsigned int num, unsigned int den));
+angle_t R_PointToAngleCrispyAt(fixed_t viewx, fixed_t viewy, fixed_t x, fixed_t y);
+
+// R_PointToAngleCrispyAt() for count points
+void R_PointToAngleBatchAt(fixed_t viewx, fixed_t viewy, angle_t * out, const fixed_t * x, const fixed_t * y, int count);
@@ -32,6 +32,8 @@
 
 //#include "r_local.hpp"
 
+#include <vector>
+
 seg_t *    curline;
 side_t *   sidedef;
 line_t *   linedef;
@@ -233,22 +235,17 @@ void R_MaybeInterpolateSector(sector_t * sector) {
 // R_AddLine
 // Clips the given segment
 // and adds any visible pieces to the line list.
+// [crispy] angle1 and angle2 are the view angles
+// of v1 and v2, computed by R_Subsector().
 //
-void R_AddLine(seg_t * line) {
+void R_AddLine(seg_t * line, angle_t angle1, angle_t angle2) {
   int     x1;
   int     x2;
-  angle_t angle1;
-  angle_t angle2;
   angle_t span;
   angle_t tspan;
 
   curline = line;
 
-  // OPTIMIZE: quickly reject orthogonal back sides.
-  // [crispy] remove slime trails
-  angle1 = R_PointToAngleCrispy(line->v1->r_x, line->v1->r_y);
-  angle2 = R_PointToAngleCrispy(line->v2->r_x, line->v2->r_y);
-
   // Clip to view edges.
   // OPTIMIZE: make constant out of 2*clipangle (FIELDOFVIEW).
   span = angle1 - angle2;
@@ -502,9 +499,30 @@ void R_Subsector(int num) {
 
   R_AddSprites(frontsector);
 
-  while (count--) {
-    R_AddLine(line);
-    line++;
+  // [crispy] the view angles of all vertices of the subsector in one go,
+  // v1 of each seg at even and v2 at odd indices
+  static std::vector<fixed_t> vertex_x, vertex_y;
+  static std::vector<angle_t> vertex_angle;
+
+  if (vertex_angle.size() < static_cast<size_t>(2 * count)) {
+    vertex_x.resize(static_cast<size_t>(2 * count));
+    vertex_y.resize(static_cast<size_t>(2 * count));
+    vertex_angle.resize(static_cast<size_t>(2 * count));
+  }
+
+  // OPTIMIZE: quickly reject orthogonal back sides.
+  // [crispy] remove slime trails
+  for (int i = 0; i < count; i++) {
+    vertex_x[2 * i]     = line[i].v1->r_x;
+    vertex_y[2 * i]     = line[i].v1->r_y;
+    vertex_x[2 * i + 1] = line[i].v2->r_x;
+    vertex_y[2 * i + 1] = line[i].v2->r_y;
+  }
+
+  R_PointToAngleBatch(vertex_angle.data(), vertex_x.data(), vertex_y.data(), 2 * count);
+
+  for (int i = 0; i < count; i++) {
+    R_AddLine(&line[i], vertex_angle[2 * i], vertex_angle[2 * i + 1]);
   }
 
   // check for solidsegs overflow - extremely unsatisfactory!
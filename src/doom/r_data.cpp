@@ -27,6 +27,7 @@
 #include "i_system.hpp"
 #include "z_zone.hpp"
 
+#include "w_prefetch.hpp"
 #include "w_wad.hpp"
 
 #include "doomdef.hpp"
@@ -500,7 +501,7 @@ void R_GenerateLookup(int texnum) {
 //
 // R_GetColumn
 //
-uint8_t *
+const uint8_t *
     R_GetColumn(int  tex,
                 int  col,
                 bool opaque) {
@@ -515,7 +516,7 @@ uint8_t *
 
   // [crispy] single-patched mid-textures on two-sided walls
   if (lump > 0 && !opaque)
-    return cache_lump_num<uint8_t *>(lump, PU_CACHE) + ofs2;
+    return view_lump_num<const uint8_t *>(lump, PU_CACHE) + ofs2;
 
   if (!texturecomposite[tex])
     R_GenerateComposite(tex);
@@ -1228,7 +1229,7 @@ void R_PrecacheLevel() {
   if (g_doomstat_globals->demoplayback)
     return;
 
-  // Precache flats.
+  // Find the flats, textures and sprites that are used.
   flatpresent = zmalloc<decltype(flatpresent)>(static_cast<size_t>(numflats), PU_STATIC, nullptr);
   std::memset(flatpresent, 0, static_cast<size_t>(numflats));
 
@@ -1237,19 +1238,6 @@ void R_PrecacheLevel() {
     flatpresent[g_r_state_globals->sectors[i].ceilingpic] = 1;
   }
 
-  flatmemory = 0;
-
-  for (int i = 0; i < numflats; i++) {
-    if (flatpresent[i]) {
-      lump = g_r_state_globals->firstflat + i;
-      flatmemory += static_cast<int>(lumpinfo[lump]->size);
-      W_CacheLumpNum(lump, PU_CACHE);
-    }
-  }
-
-  Z_Free(flatpresent);
-
-  // Precache textures.
   texturepresent = zmalloc<decltype(texturepresent)>(static_cast<size_t>(numtextures), PU_STATIC, nullptr);
   std::memset(texturepresent, 0, static_cast<size_t>(numtextures));
 
@@ -1267,6 +1255,57 @@ void R_PrecacheLevel() {
   //  name.
   texturepresent[skytexture] = 1;
 
+  spritepresent = zmalloc<decltype(spritepresent)>(static_cast<size_t>(g_r_state_globals->numsprites), PU_STATIC, nullptr);
+  std::memset(spritepresent, 0, static_cast<size_t>(g_r_state_globals->numsprites));
+
+  action_hook needle = P_MobjThinker;
+  for (th = g_p_local_globals->thinkercap.next; th != &g_p_local_globals->thinkercap; th = th->next) {
+    if (th->function == needle) {
+      mobj_t * pMobj               = reinterpret_cast<mobj_t *>(th);
+      spritepresent[pMobj->sprite] = 1;
+    }
+  }
+
+  // [crispy] queue all the reads first, so that WAD files that are
+  // not mapped are read in the background while the lumps are cached
+  for (int i = 0; i < numflats; i++) {
+    if (flatpresent[i])
+      W_PrefetchLump(g_r_state_globals->firstflat + i);
+  }
+
+  for (int i = 0; i < numtextures; i++) {
+    if (!texturepresent[i])
+      continue;
+
+    for (int j = 0; j < textures[i]->patchcount; j++) {
+      W_PrefetchLump(textures[i]->patches[j].patch);
+    }
+  }
+
+  for (int i = 0; i < g_r_state_globals->numsprites; i++) {
+    if (!spritepresent[i])
+      continue;
+
+    for (int j = 0; j < g_r_state_globals->sprites[i].numframes; j++) {
+      sf = &g_r_state_globals->sprites[i].spriteframes[j];
+      for (int k = 0; k < 8; k++) {
+        W_PrefetchLump(g_r_state_globals->firstspritelump + sf->lump[k]);
+      }
+    }
+  }
+
+  // Precache flats.
+  flatmemory = 0;
+
+  for (int i = 0; i < numflats; i++) {
+    if (flatpresent[i]) {
+      lump = g_r_state_globals->firstflat + i;
+      flatmemory += static_cast<int>(lumpinfo[lump]->size);
+      W_CacheLumpNum(lump, PU_CACHE);
+    }
+  }
+
+  // Precache textures.
   texturememory = 0;
   for (int i = 0; i < numtextures; i++) {
     if (!texturepresent[i])
@@ -1284,20 +1323,7 @@ void R_PrecacheLevel() {
     }
   }
 
-  Z_Free(texturepresent);
-
   // Precache sprites.
-  spritepresent = zmalloc<decltype(spritepresent)>(static_cast<size_t>(g_r_state_globals->numsprites), PU_STATIC, nullptr);
-  std::memset(spritepresent, 0, static_cast<size_t>(g_r_state_globals->numsprites));
-
-  action_hook needle = P_MobjThinker;
-  for (th = g_p_local_globals->thinkercap.next; th != &g_p_local_globals->thinkercap; th = th->next) {
-    if (th->function == needle) {
-      mobj_t * pMobj               = reinterpret_cast<mobj_t *>(th);
-      spritepresent[pMobj->sprite] = 1;
-    }
-  }
-
   spritememory = 0;
   for (int i = 0; i < g_r_state_globals->numsprites; i++) {
     if (!spritepresent[i])
@@ -1314,4 +1340,6 @@ void R_PrecacheLevel() {
   }
 
   Z_Free(spritepresent);
+  Z_Free(texturepresent);
+  Z_Free(flatpresent);
 }
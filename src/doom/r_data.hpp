@@ -27,7 +27,7 @@ constexpr auto LOOKDIRMAX = 90;
 constexpr auto LOOKDIRS   = (LOOKDIRMIN + 1 + LOOKDIRMAX); // [crispy] lookdir range: -110..0..90
 
 // Retrieve column data for span blitting.
-uint8_t * R_GetColumn(int  tex,
+const uint8_t * R_GetColumn(int  tex,
                       int  col,
                       bool opaque);
 
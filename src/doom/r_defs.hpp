@@ -85,6 +85,15 @@ struct degenmobj_t {
   fixed_t   z {};
 };
 
+//
+// One two-sided line of a sector and the sector on its
+// other side (nullptr if the line has no back sector).
+//
+struct sectoradj_t {
+  struct sector_t * sector;
+  struct line_t *   line;
+};
+
 //
 // The SECTORS record, at runtime.
 // Stores things/mobjs.
@@ -122,6 +131,11 @@ struct sector_t {
   int              linecount {};
   struct line_t ** lines {}; // [linecount] size
 
+  // two-sided subset of lines, in the same order,
+  // built by P_GroupLines
+  int                  adjcount {};
+  struct sectoradj_t * adjacent {}; // [adjcount] size
+
   // [crispy] WiggleFix: [kb] for R_FixWiggle()
   int cachedheight {};
   int scaleindex {};
@@ -149,6 +163,28 @@ struct sector_t {
 
   // [crispy] revealed secrets
   short oldspecial {};
+
+  // things whose bounding box touches this sector
+  struct msecnode_t * touching_thinglist {};
+
+  // bumped whenever T_MovePlane touches the floor or ceiling,
+  // so precomputed sight checks can tell they are stale
+  int heightgen {};
+};
+
+//
+// Links a thing to one sector its bounding box touches.
+// Each node is on two lists at once: the thing's
+// touching_sectorlist and the sector's touching_thinglist.
+//
+struct msecnode_t {
+  sector_t *   m_sector; // a sector containing this object
+  mobj_t *     m_thing;  // this object
+  msecnode_t * m_tprev;  // prev msecnode_t for this thing
+  msecnode_t * m_tnext;  // next msecnode_t for this thing
+  msecnode_t * m_sprev;  // prev msecnode_t for this sector
+  msecnode_t * m_snext;  // next msecnode_t for this sector
+  bool         visited;  // used by P_ChangeSector
 };
 
 //
@@ -79,7 +79,7 @@ struct r_draw_t {
   uint8_t *      dc_brightmap;
 
   // first pixel in a column (possibly virtual)
-  uint8_t * dc_source;
+  const uint8_t * dc_source;
 
   //
   // R_DrawSpan
@@ -106,7 +106,7 @@ struct r_draw_t {
   fixed_t ds_ystep;
 
   // start of a 64*64 tile image
-  uint8_t * ds_source;
+  const uint8_t * ds_source;
 
   //
   // R_DrawTranslatedColumn
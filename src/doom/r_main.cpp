@@ -19,6 +19,7 @@
 //
 
 #include <cstdlib>
+#include <vector>
 
 #include <fmt/printf.h>
 
@@ -27,8 +28,10 @@
 
 #include "m_bbox.hpp"
 #include "m_menu.hpp"
+#include "m_profile.hpp"
 
 #include "p_local.hpp" // [crispy] MLOOKUNIT
+#include "r_angle.hpp"
 #include "r_local.hpp"
 #include "r_sky.hpp"
 #include "st_stuff.hpp" // [crispy] ST_refreshBackground()
@@ -253,69 +256,12 @@ int R_PointOnSegSide(fixed_t x,
 
 // [crispy] turned into a general R_PointToAngle() flavor
 // called with either slope_div = SlopeDivCrispy() from R_PointToAngleCrispy()
-// or slope_div = SlopeDiv() else
+// or slope_div = SlopeDiv() else, see r_angle.cpp
 angle_t
     R_PointToAngleSlope(fixed_t x,
                         fixed_t y,
                         int (*slope_div)(unsigned int num, unsigned int den)) {
-  x -= g_r_state_globals->viewx;
-  y -= g_r_state_globals->viewy;
-
-  if ((!x) && (!y))
-    return 0;
-
-  if (x >= 0) {
-    // x >=0
-    if (y >= 0) {
-      // y>= 0
-
-      if (x > y) {
-        // octant 0
-        return tantoangle[slope_div(static_cast<unsigned int>(y), static_cast<unsigned int>(x))];
-      } else {
-        // octant 1
-        return ANG90 - 1 - tantoangle[slope_div(static_cast<unsigned int>(x), static_cast<unsigned int>(y))];
-      }
-    } else {
-      // y<0
-      y = -y;
-
-      if (x > y) {
-        // octant 8
-        // Subtracting from 0u avoids compiler warnings
-        return 0u - tantoangle[slope_div(static_cast<unsigned int>(y), static_cast<unsigned int>(x))];
-      } else {
-        // octant 7
-        return ANG270 + tantoangle[slope_div(static_cast<unsigned int>(x), static_cast<unsigned int>(y))];
-      }
-    }
-  } else {
-    // x<0
-    x = -x;
-
-    if (y >= 0) {
-      // y>= 0
-      if (x > y) {
-        // octant 3
-        return ANG180 - 1 - tantoangle[slope_div(static_cast<unsigned int>(y), static_cast<unsigned int>(x))];
-      } else {
-        // octant 2
-        return ANG90 + tantoangle[slope_div(static_cast<unsigned int>(x), static_cast<unsigned int>(y))];
-      }
-    } else {
-      // y<0
-      y = -y;
-
-      if (x > y) {
-        // octant 4
-        return ANG180 + tantoangle[slope_div(static_cast<unsigned int>(y), static_cast<unsigned int>(x))];
-      } else {
-        // octant 5
-        return ANG270 - 1 - tantoangle[slope_div(static_cast<unsigned int>(x), static_cast<unsigned int>(y))];
-      }
-    }
-  }
-  [[unreachable]];
+  return R_DeltaToAngleSlope(x - g_r_state_globals->viewx, y - g_r_state_globals->viewy, slope_div);
 }
 
 angle_t
@@ -325,22 +271,16 @@ angle_t
 }
 
 // [crispy] overflow-safe R_PointToAngle() flavor
-// called only from R_CheckBBox(), R_AddLine() and P_SegLengths()
+// called only from R_CheckBBox() and P_SegLengths(),
+// R_Subsector() uses R_PointToAngleBatch()
 angle_t
     R_PointToAngleCrispy(fixed_t x,
                          fixed_t y) {
-  // [crispy] fix overflows for very long distances
-  int64_t y_viewy = static_cast<int64_t>(y) - g_r_state_globals->viewy;
-  int64_t x_viewx = static_cast<int64_t>(x) - g_r_state_globals->viewx;
-
-  // [crispy] the worst that could happen is e.g. std::numeric_limits<int32_t>::min()-std::numeric_limits<int32_t>::max() = 2*std::numeric_limits<int32_t>::min()
-  if (x_viewx < std::numeric_limits<int32_t>::min() || x_viewx > std::numeric_limits<int32_t>::max() || y_viewy < std::numeric_limits<int32_t>::min() || y_viewy > std::numeric_limits<int32_t>::max()) {
-    // [crispy] preserving the angle by halfing the distance in both directions
-    x = static_cast<fixed_t>(x_viewx / 2 + g_r_state_globals->viewx);
-    y = static_cast<fixed_t>(y_viewy / 2 + g_r_state_globals->viewy);
-  }
+  return R_PointToAngleCrispyAt(g_r_state_globals->viewx, g_r_state_globals->viewy, x, y);
+}
 
-  return R_PointToAngleSlope(x, y, SlopeDivCrispy);
+void R_PointToAngleBatch(angle_t * out, const fixed_t * x, const fixed_t * y, int count) {
+  R_PointToAngleBatchAt(g_r_state_globals->viewx, g_r_state_globals->viewy, out, x, y, count);
 }
 
 angle_t
@@ -916,6 +856,8 @@ void R_SetupFrame(player_t * player) {
 // R_RenderView
 //
 void R_RenderPlayerView(player_t * player) {
+  PROFILE_ZONE("R_RenderPlayerView");
+
   extern void V_DrawFilledBox(int x, int y, int w, int h, int c);
   extern void R_InterpolateTextureOffsets();
 
@@ -109,6 +109,9 @@ angle_t
     R_PointToAngleCrispy(fixed_t x,
                          fixed_t y);
 
+// [crispy] R_PointToAngleCrispy() for count points
+void R_PointToAngleBatch(angle_t * out, const fixed_t * x, const fixed_t * y, int count);
+
 angle_t
     R_PointToAngle2(fixed_t x1,
                     fixed_t y1,
@@ -434,7 +434,7 @@ void R_DrawPlanes() {
     } else {
       // regular flat
       lumpnum                     = g_r_state_globals->firstflat + g_r_state_globals->flattranslation[pl->picnum];
-      g_r_draw_globals->ds_source = cache_lump_num<uint8_t *>(lumpnum, PU_STATIC);
+      g_r_draw_globals->ds_source = view_lump_num<const uint8_t *>(lumpnum, PU_STATIC);
     }
 
     g_r_draw_globals->ds_brightmap = R_BrightmapForFlatNum(lumpnum - g_r_state_globals->firstflat);
@@ -259,8 +259,8 @@ void R_RenderMaskedSegRange(drawseg_t * ds,
       g_r_draw_globals->dc_iscale = static_cast<fixed_t>(0xffffffffu / static_cast<unsigned>(spryscale));
 
       // draw the texture
-      auto * col_ptr = reinterpret_cast<uint8_t *>(R_GetColumn(texnum, maskedtexturecol[g_r_draw_globals->dc_x], false) - 3);
-      auto * col     = reinterpret_cast<column_t *>(col_ptr);
+      const auto * col_ptr = R_GetColumn(texnum, maskedtexturecol[g_r_draw_globals->dc_x], false) - 3;
+      const auto * col     = reinterpret_cast<const column_t *>(col_ptr);
 
       R_DrawMaskedColumn(col);
       maskedtexturecol[g_r_draw_globals->dc_x] = std::numeric_limits<int32_t>::max(); // [crispy] 32-bit integer math
@@ -280,8 +280,59 @@ void R_RenderMaskedSegRange(drawseg_t * ds,
 constexpr auto                  HEIGHTBITS = 12;
 [[maybe_unused]] constexpr auto HEIGHTUNIT = (1 << HEIGHTBITS);
 
+// [crispy] per-column values of the current seg, computed up front
+static int     segyl[MAXWIDTH];
+static int     segyh[MAXWIDTH];
+static int     segpixhigh[MAXWIDTH];
+static int     segpixlow[MAXWIDTH];
+static fixed_t segscale[MAXWIDTH];
+static fixed_t segtexturecolumn[MAXWIDTH];
+
+//
+// R_SetupSegColumns
+// The first pass of R_RenderSegLoop. The stepped values are computed
+// from their start values in closed form instead of incrementally, so
+// that no column depends on the one before it. The 64-bit sums are
+// exact and the 32-bit scale wraps the same way, so every value is
+// identical to what the incremental loop produces.
+//
+static void R_SetupSegColumns(int count) {
+  for (int i = 0; i < count; i++) {
+    segyl[i]    = static_cast<int>((topfrac + static_cast<int64_t>(i) * topstep + heightunit - 1) >> heightbits); // [crispy] WiggleFix
+    segyh[i]    = static_cast<int>((bottomfrac + static_cast<int64_t>(i) * bottomstep) >> heightbits);         // [crispy] WiggleFix
+    segscale[i] = static_cast<fixed_t>(static_cast<uint32_t>(rw_scale) + static_cast<uint32_t>(i) * static_cast<uint32_t>(rw_scalestep));
+  }
+
+  if (!midtexture) {
+    if (toptexture) {
+      for (int i = 0; i < count; i++) {
+        segpixhigh[i] = static_cast<int>((pixhigh + static_cast<int64_t>(i) * pixhighstep) >> heightbits); // [crispy] WiggleFix
+      }
+    }
+
+    if (bottomtexture) {
+      for (int i = 0; i < count; i++) {
+        segpixlow[i] = static_cast<int>((pixlow + static_cast<int64_t>(i) * pixlowstep + heightunit - 1) >> heightbits); // [crispy] WiggleFix
+      }
+    }
+  }
+
+  if (segtextured) {
+    // calculate texture offsets
+    for (int i = 0; i < count; i++) {
+      const angle_t angle = (rw_centerangle + g_r_state_globals->xtoviewangle[rw_x + i]) >> ANGLETOFINESHIFT;
+      segtexturecolumn[i] = finetangent[angle];
+    }
+
+    FixedMulBatch(segtexturecolumn, segtexturecolumn, g_r_state_globals->rw_distance, count);
+
+    for (int i = 0; i < count; i++) {
+      segtexturecolumn[i] = (rw_offset - segtexturecolumn[i]) >> FRACBITS;
+    }
+  }
+}
+
 void R_RenderSegLoop() {
-  angle_t angle;
   int     yl;
   int     yh;
   int     mid;
@@ -289,9 +340,15 @@ void R_RenderSegLoop() {
   int     top;
   int     bottom;
 
+  const int start = rw_x;
+
+  R_SetupSegColumns(rw_stopx - start);
+
   for (; rw_x < rw_stopx; rw_x++) {
+    const int i = rw_x - start;
+
     // mark floor / ceiling areas
-    yl = static_cast<int>((topfrac + heightunit - 1) >> heightbits); // [crispy] WiggleFix
+    yl = segyl[i];
 
     // no space above wall?
     if (yl < ceilingclip[rw_x] + 1)
@@ -310,7 +367,7 @@ void R_RenderSegLoop() {
       }
     }
 
-    yh = static_cast<int>(bottomfrac >> heightbits); // [crispy] WiggleFix
+    yh = segyh[i];
 
     if (yh >= floorclip[rw_x])
       yh = floorclip[rw_x] - 1;
@@ -328,12 +385,9 @@ void R_RenderSegLoop() {
 
     // texturecolumn and lighting are independent of wall tiers
     if (segtextured) {
-      // calculate texture offset
-      angle         = (rw_centerangle + g_r_state_globals->xtoviewangle[rw_x]) >> ANGLETOFINESHIFT;
-      texturecolumn = rw_offset - FixedMul(finetangent[angle], g_r_state_globals->rw_distance);
-      texturecolumn >>= FRACBITS;
+      texturecolumn = segtexturecolumn[i];
       // calculate lighting
-      int index = rw_scale >> (LIGHTSCALESHIFT + crispy->hires);
+      int index = segscale[i] >> (LIGHTSCALESHIFT + crispy->hires);
 
       if (index >= MAXLIGHTSCALE)
         index = MAXLIGHTSCALE - 1;
@@ -342,7 +396,7 @@ void R_RenderSegLoop() {
       g_r_draw_globals->dc_colormap[0] = walllights[index];
       g_r_draw_globals->dc_colormap[1] = (!fixedcolormap && (crispy->brightmaps & BRIGHTMAPS_TEXTURES)) ? scalelight[LIGHTLEVELS - 1][MAXLIGHTSCALE - 1] : g_r_draw_globals->dc_colormap[0];
       g_r_draw_globals->dc_x           = rw_x;
-      g_r_draw_globals->dc_iscale      = static_cast<fixed_t>(0xffffffffu / static_cast<unsigned>(rw_scale));
+      g_r_draw_globals->dc_iscale      = static_cast<fixed_t>(0xffffffffu / static_cast<unsigned>(segscale[i]));
     } else {
       // purely to shut up the compiler
 
@@ -365,8 +419,7 @@ void R_RenderSegLoop() {
       // two sided line
       if (toptexture) {
         // top wall
-        mid = static_cast<int>(pixhigh >> heightbits); // [crispy] WiggleFix
-        pixhigh += pixhighstep;
+        mid = segpixhigh[i];
 
         if (mid >= floorclip[rw_x])
           mid = floorclip[rw_x] - 1;
@@ -390,8 +443,7 @@ void R_RenderSegLoop() {
 
       if (bottomtexture) {
         // bottom wall
-        mid = static_cast<int>((pixlow + heightunit - 1) >> heightbits); // [crispy] WiggleFix
-        pixlow += pixlowstep;
+        mid = segpixlow[i];
 
         // no space above wall?
         if (mid <= ceilingclip[rw_x])
@@ -422,10 +474,6 @@ void R_RenderSegLoop() {
         maskedtexturecol[rw_x] = texturecolumn;
       }
     }
-
-    rw_scale += rw_scalestep;
-    topfrac += topstep;
-    bottomfrac += bottomstep;
   }
 }
 
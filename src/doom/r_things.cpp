@@ -360,7 +360,7 @@ int * mceilingclip; // [crispy] 32-bit integer math
 fixed_t spryscale;
 int64_t sprtopscreen; // [crispy] WiggleFix
 
-void R_DrawMaskedColumn(column_t * column) {
+void R_DrawMaskedColumn(const column_t * column) {
   int64_t topscreen;    // [crispy] WiggleFix
   int64_t bottomscreen; // [crispy] WiggleFix
   fixed_t basetexturemid;
@@ -390,7 +390,7 @@ void R_DrawMaskedColumn(column_t * column) {
       g_r_draw_globals->dc_yl = mceilingclip[g_r_draw_globals->dc_x] + 1;
 
     if (g_r_draw_globals->dc_yl <= g_r_draw_globals->dc_yh) {
-      g_r_draw_globals->dc_source     = reinterpret_cast<uint8_t *>(column) + 3;
+      g_r_draw_globals->dc_source     = reinterpret_cast<const uint8_t *>(column) + 3;
       g_r_draw_globals->dc_texturemid = basetexturemid - (top << FRACBITS);
       // dc_source = (byte *)column + 3 - top;
 
@@ -398,8 +398,8 @@ void R_DrawMaskedColumn(column_t * column) {
       //  or (SHADOW) R_DrawFuzzColumn.
       colfunc();
     }
-    uint8_t * col_ptr = reinterpret_cast<uint8_t *>(column) + column->length + 4;
-    column            = reinterpret_cast<column_t *>(col_ptr);
+    const uint8_t * col_ptr = reinterpret_cast<const uint8_t *>(column) + column->length + 4;
+    column                  = reinterpret_cast<const column_t *>(col_ptr);
   }
 
   g_r_draw_globals->dc_texturemid = basetexturemid;
@@ -410,12 +410,12 @@ void R_DrawMaskedColumn(column_t * column) {
 //  mfloorclip and mceilingclip should also be set.
 //
 void R_DrawVisSprite(vissprite_t * vis, int, int) {
-  column_t * column;
-  int        texturecolumn;
-  fixed_t    frac;
-  patch_t *  patch;
+  const column_t * column;
+  int              texturecolumn;
+  fixed_t          frac;
+  const patch_t *  patch;
 
-  patch = cache_lump_num<patch_t *>(vis->patch + g_r_state_globals->firstspritelump, PU_CACHE);
+  patch = view_lump_num<const patch_t *>(vis->patch + g_r_state_globals->firstspritelump, PU_CACHE);
 
   // [crispy] brightmaps for select sprites
   g_r_draw_globals->dc_colormap[0] = vis->colormap[0];
@@ -465,8 +465,8 @@ void R_DrawVisSprite(vissprite_t * vis, int, int) {
       continue;
     }
 #endif
-    uint8_t * col_ptr = reinterpret_cast<uint8_t *>(patch) + LONG(patch->columnofs[texturecolumn]);
-    column            = reinterpret_cast<column_t *>(col_ptr);
+    const uint8_t * col_ptr = reinterpret_cast<const uint8_t *>(patch) + LONG(patch->columnofs[texturecolumn]);
+    column                  = reinterpret_cast<const column_t *>(col_ptr);
     R_DrawMaskedColumn(column);
   }
 
@@ -38,7 +38,7 @@ extern int64_t sprtopscreen; // [crispy] WiggleFix
 extern fixed_t pspritescale;
 extern fixed_t pspriteiscale;
 
-void R_DrawMaskedColumn(column_t * column);
+void R_DrawMaskedColumn(const column_t * column);
 
 void R_SortVisSprites();
 
@@ -35,6 +35,7 @@
 
 #include "lump.hpp"
 #include "m_misc.hpp"
+#include "m_profile.hpp"
 #include "m_random.hpp"
 #include "p_local.hpp"
 #include "w_wad.hpp"
@@ -681,6 +682,8 @@ void S_ResumeSound() {
 //
 
 void S_UpdateSounds(mobj_t * listener) {
+  PROFILE_ZONE("S_UpdateSounds");
+
   int         audible;
   int         cnum;
   int         volume;
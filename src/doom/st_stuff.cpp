@@ -292,6 +292,7 @@ cheatseq_t  cheat_spechits   = CHEAT("spechits", 0);
 cheatseq_t  cheat_nomomentum = CHEAT("nomomentum", 0);
 cheatseq_t  cheat_showfps    = CHEAT("showfps", 0);
 cheatseq_t  cheat_showfps2   = CHEAT("idrate", 0); // [crispy] PrBoom+
+cheatseq_t  cheat_showzone   = CHEAT("showzone", 0);
 cheatseq_t  cheat_goobers    = CHEAT("goobers", 0);
 cheatseq_t  cheat_version    = CHEAT("version", 0); // [crispy] Russian Doom
 cheatseq_t  cheat_skill      = CHEAT("skill", 0);
@@ -849,6 +850,13 @@ plyr->message = buf;
     if (cht_CheckCheat(&cheat_showfps, static_cast<char>(ev->data2)) || cht_CheckCheat(&cheat_showfps2, static_cast<char>(ev->data2))) {
       plyr->powers[pw_showfps] ^= 1;
     }
+    // [crispy] zone heap statistics, see -zonestats
+    else if (cht_CheckCheat(&cheat_showzone, static_cast<char>(ev->data2))) {
+      crispy->showzone = !crispy->showzone;
+
+      M_snprintf(msg, sizeof(msg), "Zone Statistics %s%s", crstr[static_cast<int>(cr_t::CR_GREEN)], (crispy->showzone) ? "ON" : "OFF");
+      plyr->message = msg;
+    }
     // [crispy] implement Boom's "tnthom" cheat
     else if (cht_CheckCheat(&cheat_hom, static_cast<char>(ev->data2))) {
       crispy->flashinghom = !crispy->flashinghom;
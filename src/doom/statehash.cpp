@@ -0,0 +1,106 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Per-tic playsim state hashes for finding desyncs.
+//
+//	Every tic the playsim runs, one line is written:
+//
+//	    <tic> <episode> <map> <leveltime> <hash>
+//
+//	where tic counts the hashed tics from the start of the run.
+//	Two runs of the same demo, e.g. before and after an optimization,
+//	can then be compared to find the first tic at which they diverge.
+//
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+
+#include <fmt/printf.h>
+
+#include "doomstat.hpp"
+#include "i_system.hpp"
+#include "p_tick.hpp"
+#include "statehash.hpp"
+
+static FILE * hashfile;
+static int    hashtic;
+
+static void StateHashClose() {
+  if (hashfile != nullptr) {
+    fclose(hashfile);
+    hashfile = nullptr;
+  }
+}
+
+void StateHashOpen(const char * filename) {
+  hashfile = fopen(filename, "w");
+
+  if (hashfile == nullptr) {
+    I_Error("StateHashOpen: Couldn't open %s for writing", filename);
+  }
+
+  I_AtExit(StateHashClose, true);
+}
+
+// Called after each P_Ticker() that advanced leveltime.
+
+void StateHashTicker() {
+  if (hashfile == nullptr) {
+    return;
+  }
+
+  fprintf(hashfile, "%d %d %d %d %016" PRIx64 "\n", hashtic++, g_doomstat_globals->gameepisode, g_doomstat_globals->gamemap, leveltime, P_StateHash());
+}
+
+bool StateHashCompare(const char * filename1, const char * filename2) {
+  FILE * file1 = fopen(filename1, "r");
+  FILE * file2 = fopen(filename2, "r");
+
+  if (file1 == nullptr || file2 == nullptr) {
+    I_Error("StateHashCompare: Couldn't open %s", file1 == nullptr ? filename1 : filename2);
+  }
+
+  int  tic1, episode1, map1, leveltime1;
+  int  tic2, episode2, map2, leveltime2;
+  char hash1[17], hash2[17];
+  bool match = true;
+
+  while (true) {
+    const bool have1 = fscanf(file1, "%d %d %d %d %16s", &tic1, &episode1, &map1, &leveltime1, hash1) == 5;
+    const bool have2 = fscanf(file2, "%d %d %d %d %16s", &tic2, &episode2, &map2, &leveltime2, hash2) == 5;
+
+    if (!have1 && !have2) {
+      fmt::printf("StateHashCompare: No differences.\n");
+      break;
+    }
+
+    if (have1 != have2) {
+      fmt::printf("StateHashCompare: %s ends at tic %d.\n", have1 ? filename2 : filename1, have1 ? tic1 : tic2);
+      match = false;
+      break;
+    }
+
+    if (episode1 != episode2 || map1 != map2 || leveltime1 != leveltime2 || strcmp(hash1, hash2) != 0) {
+      fmt::printf("StateHashCompare: First difference at tic %d (E%dM%d, leveltime %d).\n", tic1, episode1, map1, leveltime1);
+      match = false;
+      break;
+    }
+  }
+
+  fclose(file1);
+  fclose(file2);
+
+  return match;
+}
@@ -0,0 +1,25 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Per-tic playsim state hashes for finding desyncs.
+//
+
+#pragma once
+
+void StateHashOpen(const char * filename);
+void StateHashTicker();
+
+// Compare two hash files, print the first diverging tic.
+// Returns true if the files match.
+bool StateHashCompare(const char * filename1, const char * filename2);
@@ -0,0 +1,85 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Zone heap statistics, written at every level exit.
+//
+//	For every level, the zone heap is written out as it is before
+//	the level data is freed: bytes and blocks by tag, free memory
+//	and how fragmented it is, and the purge and zone grow counts so
+//	far. Levels that need a zone grow show how large -mb has to be,
+//	and the PU_LEVSPEC line shows how much the special thinkers of a
+//	level still hold when it ends. The "showzone" cheat shows the
+//	same numbers live.
+//
+
+#include <cstdio>
+
+#include "doomstat.hpp"
+#include "i_system.hpp"
+#include "z_zone.hpp"
+#include "zonestats.hpp"
+
+static FILE * statsfile;
+
+static const char * const tag_names[PU_NUM_TAGS] = {
+  nullptr,
+  "PU_STATIC",
+  "PU_SOUND",
+  "PU_MUSIC",
+  nullptr, // PU_FREE
+  "PU_LEVEL",
+  "PU_LEVSPEC",
+  "PU_PURGELEVEL",
+  "PU_CACHE",
+};
+
+static void ZoneStatsClose() {
+  if (statsfile != nullptr) {
+    fclose(statsfile);
+    statsfile = nullptr;
+  }
+}
+
+void ZoneStatsOpen(const char * filename) {
+  statsfile = fopen(filename, "w");
+
+  if (statsfile == nullptr) {
+    I_Error("ZoneStatsOpen: Couldn't open %s for writing", filename);
+  }
+
+  I_AtExit(ZoneStatsClose, true);
+}
+
+// Called from G_DoCompleted(), while the level is still loaded.
+
+void ZoneStatsLevelExit() {
+  if (statsfile == nullptr) {
+    return;
+  }
+
+  zone_stats_t stats;
+  Z_GetStats(&stats);
+
+  fprintf(statsfile, "episode %d map %d leveltime %d\n", g_doomstat_globals->gameepisode, g_doomstat_globals->gamemap, leveltime);
+
+  for (int tag = 0; tag < PU_NUM_TAGS; tag++) {
+    if (tag_names[tag] != nullptr) {
+      fprintf(statsfile, "  %-14s %8d blocks %10zu bytes\n", tag_names[tag], stats.tag_blocks[tag], stats.tag_bytes[tag]);
+    }
+  }
+
+  fprintf(statsfile, "  %-14s %8d blocks %10zu bytes, largest %zu, fragmentation %.1f%%\n", "free", stats.free_blocks, stats.free_bytes, stats.largest_free, 100.0 * Z_Fragmentation(stats));
+  fprintf(statsfile, "  zone %zu bytes, %d purges, %d grows\n", stats.zone_bytes, stats.purges, stats.grows);
+  fflush(statsfile);
+}
@@ -16,11 +16,15 @@
 //	System interface for music.
 //
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <cctype>
 #include <cstdlib>
 #include <cstring>
 #include <memory>
+#include <thread>
+#include <vector>
 
 #include <fmt/printf.h>
 
@@ -859,10 +863,14 @@ static bool IsMusicLump(int lumpnum) {
 // Dump an example config file containing checksums for all MIDI music
 // found in the WAD directory.
 
+struct music_hash_t {
+  lumpindex_t   lumpnum;
+  uint8_t *     data;
+  sha1_digest_t digest;
+};
+
 static void DumpSubstituteConfig(char * filename) {
-  sha1_context_t context;
-  sha1_digest_t  digest;
-  char           name[9];
+  char name[9];
 
   FILE * fs = fopen(filename, "w");
   if (fs == nullptr) {
@@ -873,23 +881,47 @@ static void DumpSubstituteConfig(char * filename) {
   fmt::fprintf(fs, "# Example %s substitute MIDI file.\n\n", PACKAGE_NAME);
   fmt::fprintf(fs, "# SHA1 hash                              = filename\n");
 
-  for (lumpindex_t lumpnum = 0; lumpnum < static_cast<int>(numlumps); ++lumpnum) {
-    strncpy(name, lumpinfo[lumpnum]->name, 8);
-    name[8] = '\0';
+  // [crispy] Load the music lumps here, the zone is not thread safe,
+  // then hash them on worker threads.
+  std::vector<music_hash_t> music;
 
-    if (!IsMusicLump(lumpnum)) {
-      continue;
+  for (lumpindex_t lumpnum = 0; lumpnum < static_cast<int>(numlumps); ++lumpnum) {
+    if (IsMusicLump(lumpnum)) {
+      music.push_back({ lumpnum, cache_lump_num<uint8_t *>(lumpnum, PU_STATIC), {} });
     }
+  }
+
+  const unsigned int numworkers = std::max(std::min(std::thread::hardware_concurrency(), static_cast<unsigned int>(music.size())), 1U);
+
+  std::atomic<size_t>      next { 0 };
+  std::vector<std::thread> workers;
 
-    // Calculate hash.
-    uint8_t * data = cache_lump_num<uint8_t *>(lumpnum, PU_STATIC);
-    SHA1_Init(&context);
-    SHA1_Update(&context, data, W_LumpLength(lumpnum));
-    SHA1_Final(digest, &context);
-    W_ReleaseLumpNum(lumpnum);
+  for (unsigned int i = 0; i < numworkers; i++) {
+    workers.emplace_back([&]() {
+      size_t index;
+      while ((index = next++) < music.size()) {
+        sha1_context_t context;
+
+        // Calculate hash.
+        SHA1_Init(&context);
+        SHA1_Update(&context, music[index].data, W_LumpLength(music[index].lumpnum));
+        SHA1_Final(music[index].digest, &context);
+      }
+    });
+  }
+
+  for (auto & worker : workers) {
+    worker.join();
+  }
+
+  for (auto & lump : music) {
+    W_ReleaseLumpNum(lump.lumpnum);
+
+    strncpy(name, lumpinfo[lump.lumpnum]->name, 8);
+    name[8] = '\0';
 
     // Print line.
-    for (unsigned char & sha : digest) {
+    for (unsigned char & sha : lump.digest) {
       fmt::fprintf(fs, "%02x", sha);
     }
 
@@ -65,7 +65,7 @@ static int    mixer_freq;
 static Uint16 mixer_format;
 static int    mixer_channels;
 static bool   use_sfx_prefix;
-static bool (*ExpandSoundData)(sfxinfo_t * sfxinfo, uint8_t * data, int samplerate, int bits, int length) = nullptr;
+static bool (*ExpandSoundData)(sfxinfo_t * sfxinfo, const uint8_t * data, int samplerate, int bits, int length) = nullptr;
 
 // Doubly-linked list of allocated sounds.
 // When a sound is played, it is moved to the head, so that the oldest
@@ -355,11 +355,11 @@ static int SRC_ConversionMode() {
 // Returns number of clipped samples.
 // DWF 2008-02-10 with cleanups by Simon Howard.
 
-static bool ExpandSoundData_SRC(sfxinfo_t * sfxinfo,
-                                uint8_t *      data,
-                                int         samplerate,
-                                int         bits,
-                                int         length) {
+static bool ExpandSoundData_SRC(sfxinfo_t *     sfxinfo,
+                                const uint8_t * data,
+                                int             samplerate,
+                                int             bits,
+                                int             length) {
   SRC_DATA src_data;
   uint32_t abuf_index = 0, clipped = 0;
   //    uint32_t alen;
@@ -541,7 +541,7 @@ static void WriteWAV(char * filename, byte * data, uint32_t length, int samplera
 // Generic sound expansion function for any sample rate.
 // Returns number of clipped samples (always 0).
 
-static bool ExpandSoundData_SDL(sfxinfo_t * sfxinfo, uint8_t * data, int samplerate, int bits, int length) {
+static bool ExpandSoundData_SDL(sfxinfo_t * sfxinfo, const uint8_t * data, int samplerate, int bits, int length) {
   uint32_t samplecount = length / (bits / 8);
 
   // Calculate the length of the expanded version of the sample.
@@ -655,9 +655,10 @@ static bool CacheSFX(sfxinfo_t * sfxinfo) {
 
   // need to load the sound
 
-  int    lumpnum = sfxinfo->lumpnum;
-  auto * data    = cache_lump_num<uint8_t *>(lumpnum, PU_STATIC);
-  size_t lumplen = W_LumpLength(lumpnum);
+  // [crispy] the lump is only read, then converted into the sound chunk
+  const lump_view_t lump    = W_LumpView(sfxinfo->lumpnum, PU_STATIC);
+  const uint8_t *   data    = lump.data;
+  size_t            lumplen = lump.size;
 
   // [crispy] Check if this is a valid RIFF wav file
   if (lumplen > 44 && memcmp(data, "RIFF", 4) == 0 && memcmp(data + 8, "WAVEfmt ", 8) == 0) {
@@ -746,7 +747,7 @@ static bool CacheSFX(sfxinfo_t * sfxinfo) {
 
   // don't need the original lump any more
 
-  W_ReleaseLumpNum(lumpnum);
+  W_ReleaseLumpView(sfxinfo->lumpnum);
 
   return true;
 }
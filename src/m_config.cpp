@@ -1770,6 +1770,12 @@ static default_t extra_defaults_list[] = {
 
   CONFIG_VARIABLE_KEY(key_demo_quit),
 
+  //!
+  // Key to rewind demo playback, if started with -rewind.
+  //
+
+  CONFIG_VARIABLE_KEY(key_demo_rewind),
+
   //!
   // Key to send a message during multiplayer games.
   //
@@ -96,10 +96,11 @@ static m_controls_t m_controls_s = {
   .key_arti_egg             = '6',
   .key_arti_invulnerability = '5',
 
-  .key_demo_quit  = 'q',
-  .key_spy        = KEY_F12,
-  .key_prevweapon = 0,
-  .key_nextweapon = 0,
+  .key_demo_quit   = 'q',
+  .key_demo_rewind = KEY_BACKSPACE,
+  .key_spy         = KEY_F12,
+  .key_prevweapon  = 0,
+  .key_nextweapon  = 0,
 
   .key_map_north     = KEY_UPARROW,
   .key_map_south     = KEY_DOWNARROW,
@@ -376,6 +377,7 @@ void M_BindMenuControls() {
   M_BindIntVariable("key_menu_cleanscreenshot", &g_m_controls_globals->key_menu_cleanscreenshot); // [crispy]
   M_BindIntVariable("key_menu_del", &g_m_controls_globals->key_menu_del);                         // [crispy]
   M_BindIntVariable("key_demo_quit", &g_m_controls_globals->key_demo_quit);
+  M_BindIntVariable("key_demo_rewind", &g_m_controls_globals->key_demo_rewind); // [crispy]
   M_BindIntVariable("key_spy", &g_m_controls_globals->key_spy);
   M_BindIntVariable("key_menu_nextlevel", &g_m_controls_globals->key_menu_nextlevel);     // [crispy]
   M_BindIntVariable("key_menu_reloadlevel", &g_m_controls_globals->key_menu_reloadlevel); // [crispy]
@@ -98,6 +98,7 @@ struct m_controls_t {
   int key_arti_invulnerability;
 
   int key_demo_quit;
+  int key_demo_rewind;
   int key_spy;
   int key_prevweapon;
   int key_nextweapon;
@@ -22,6 +22,14 @@
 #include "doomtype.hpp"
 #include "m_fixed.hpp"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FIXED_SSE2
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define FIXED_NEON
+#include <arm_neon.h>
+#endif
+
 // Fixme. __USE_C_FIXED__ or something.
 
 fixed_t FixedMul(fixed_t a, fixed_t b) {
@@ -40,3 +48,161 @@ fixed_t FixedDiv(fixed_t a, fixed_t b) {
     return static_cast<fixed_t>(result);
   }
 }
+
+//
+// Batch versions, four lanes at a time.
+//
+// FixedMul only needs bits 16..47 of the 64-bit product, which a
+// logical shift extracts as well as an arithmetic one.
+//
+// FixedDiv divides in double precision: |a << 16| <= 2^47 and b are
+// exact, and a quotient that is not an integer is at least 1/|b| away
+// from one, far more than the rounding error, so truncating the double
+// quotient gives the same result as the 64-bit integer division.
+// The overflow check is done on 32-bit lanes exactly as above. Since
+// std::abs(INT_MIN) wraps, INT_MIN / b is not caught by it and its
+// quotient may not fit in 32 bits, the scalar code truncates it.
+//
+
+#if defined(FIXED_SSE2)
+
+// SSE2 has no signed 32x32->64 multiply, so the unsigned product is
+// corrected by subtracting (a < 0 ? b : 0) + (b < 0 ? a : 0) from its
+// high half.
+static inline __m128i FixedMul4(__m128i a, __m128i b) {
+  const __m128i low_mask   = _mm_set_epi32(0, -1, 0, -1);
+  const __m128i correction = _mm_add_epi32(_mm_and_si128(_mm_srai_epi32(a, 31), b),
+                                           _mm_and_si128(_mm_srai_epi32(b, 31), a));
+
+  __m128i even = _mm_mul_epu32(a, b);
+  __m128i odd  = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+
+  even = _mm_sub_epi64(even, _mm_slli_epi64(correction, 32));
+  odd  = _mm_sub_epi64(odd, _mm_andnot_si128(low_mask, correction));
+
+  return _mm_or_si128(_mm_and_si128(_mm_srli_epi64(even, FRACBITS), low_mask),
+                      _mm_andnot_si128(low_mask, _mm_slli_epi64(odd, FRACBITS)));
+}
+
+static inline __m128i FixedDiv4(__m128i a, __m128i b) {
+  const __m128i sign_a = _mm_srai_epi32(a, 31);
+  const __m128i sign_b = _mm_srai_epi32(b, 31);
+  const __m128i abs_a  = _mm_sub_epi32(_mm_xor_si128(a, sign_a), sign_a);
+  const __m128i abs_b  = _mm_sub_epi32(_mm_xor_si128(b, sign_b), sign_b);
+
+  // (abs(a) >> 14) >= abs(b)
+  const __m128i overflow  = _mm_xor_si128(_mm_cmpgt_epi32(abs_b, _mm_srai_epi32(abs_a, 14)), _mm_set1_epi32(-1));
+  const __m128i saturated = _mm_xor_si128(_mm_srai_epi32(_mm_xor_si128(a, b), 31), _mm_set1_epi32(std::numeric_limits<int32_t>::max()));
+
+  const __m128d scale = _mm_set1_pd(FRACUNIT);
+  const __m128d q_low = _mm_div_pd(_mm_mul_pd(_mm_cvtepi32_pd(a), scale), _mm_cvtepi32_pd(b));
+  const __m128d q_high = _mm_div_pd(_mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(a, 8)), scale),
+                                    _mm_cvtepi32_pd(_mm_srli_si128(b, 8)));
+
+  const __m128i quotient = _mm_unpacklo_epi64(_mm_cvttpd_epi32(q_low), _mm_cvttpd_epi32(q_high));
+
+  return _mm_or_si128(_mm_and_si128(overflow, saturated), _mm_andnot_si128(overflow, quotient));
+}
+
+#elif defined(FIXED_NEON)
+
+static inline int32x4_t FixedMul4(int32x4_t a, int32x4_t b) {
+  const int64x2_t low  = vmull_s32(vget_low_s32(a), vget_low_s32(b));
+  const int64x2_t high = vmull_s32(vget_high_s32(a), vget_high_s32(b));
+
+  return vcombine_s32(vshrn_n_s64(low, FRACBITS), vshrn_n_s64(high, FRACBITS));
+}
+
+static inline int32x4_t FixedDiv4(int32x4_t a, int32x4_t b) {
+  // vabsq_s32 wraps INT_MIN like std::abs does in practice
+  const uint32x4_t overflow  = vcgeq_s32(vshrq_n_s32(vabsq_s32(a), 14), vabsq_s32(b));
+  const int32x4_t  saturated = veorq_s32(vshrq_n_s32(veorq_s32(a, b), 31), vdupq_n_s32(std::numeric_limits<int32_t>::max()));
+
+  const float64x2_t scale  = vdupq_n_f64(FRACUNIT);
+  const int64x2_t   a_low  = vmovl_s32(vget_low_s32(a));
+  const int64x2_t   a_high = vmovl_s32(vget_high_s32(a));
+  const int64x2_t   b_low  = vmovl_s32(vget_low_s32(b));
+  const int64x2_t   b_high = vmovl_s32(vget_high_s32(b));
+
+  const float64x2_t q_low  = vdivq_f64(vmulq_f64(vcvtq_f64_s64(a_low), scale), vcvtq_f64_s64(b_low));
+  const float64x2_t q_high = vdivq_f64(vmulq_f64(vcvtq_f64_s64(a_high), scale), vcvtq_f64_s64(b_high));
+
+  const int32x4_t quotient = vcombine_s32(vmovn_s64(vcvtq_s64_f64(q_low)), vmovn_s64(vcvtq_s64_f64(q_high)));
+
+  return vbslq_s32(overflow, saturated, quotient);
+}
+
+#endif
+
+void FixedMulBatch(fixed_t * out, const fixed_t * a, const fixed_t * b, int count) {
+  int i = 0;
+
+#if defined(FIXED_SSE2)
+  for (; i + 4 <= count; i += 4) {
+    const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+    const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), FixedMul4(va, vb));
+  }
+#elif defined(FIXED_NEON)
+  for (; i + 4 <= count; i += 4) {
+    vst1q_s32(out + i, FixedMul4(vld1q_s32(a + i), vld1q_s32(b + i)));
+  }
+#endif
+
+  for (; i < count; i++) {
+    out[i] = FixedMul(a[i], b[i]);
+  }
+}
+
+void FixedMulBatch(fixed_t * out, const fixed_t * a, fixed_t b, int count) {
+  int i = 0;
+
+#if defined(FIXED_SSE2)
+  const __m128i vb = _mm_set1_epi32(b);
+  for (; i + 4 <= count; i += 4) {
+    const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), FixedMul4(va, vb));
+  }
+#elif defined(FIXED_NEON)
+  const int32x4_t vb = vdupq_n_s32(b);
+  for (; i + 4 <= count; i += 4) {
+    vst1q_s32(out + i, FixedMul4(vld1q_s32(a + i), vb));
+  }
+#endif
+
+  for (; i < count; i++) {
+    out[i] = FixedMul(a[i], b);
+  }
+}
+
+void FixedDivBatch(fixed_t * out, const fixed_t * a, const fixed_t * b, int count) {
+  int i = 0;
+
+#if defined(FIXED_SSE2)
+  const __m128i int_min = _mm_set1_epi32(std::numeric_limits<int32_t>::min());
+
+  for (; i + 4 <= count; i += 4) {
+    const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+    const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+
+    // SSE2 can only convert doubles to 32 bits, leave INT_MIN / b
+    // to the scalar code
+    if (_mm_movemask_epi8(_mm_cmpeq_epi32(va, int_min)) != 0) {
+      for (int j = i; j < i + 4; j++) {
+        out[j] = FixedDiv(a[j], b[j]);
+      }
+      continue;
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), FixedDiv4(va, vb));
+  }
+#elif defined(FIXED_NEON)
+  for (; i + 4 <= count; i += 4) {
+    vst1q_s32(out + i, FixedDiv4(vld1q_s32(a + i), vld1q_s32(b + i)));
+  }
+#endif
+
+  for (; i < count; i++) {
+    out[i] = FixedDiv(a[i], b[i]);
+  }
+}
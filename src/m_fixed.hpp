@@ -34,3 +34,9 @@ using fixed_t = int32_t;
 
 fixed_t FixedMul(fixed_t a, fixed_t b);
 fixed_t FixedDiv(fixed_t a, fixed_t b);
+
+// Batch versions for setup loops. out[i] is exactly what the scalar
+// function returns for the i-th operands, on every platform.
+void FixedMulBatch(fixed_t * out, const fixed_t * a, const fixed_t * b, int count);
+void FixedMulBatch(fixed_t * out, const fixed_t * a, fixed_t b, int count);
+void FixedDivBatch(fixed_t * out, const fixed_t * a, const fixed_t * b, int count);
@@ -0,0 +1,142 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Scoped profiler zones, written as a Chrome trace on exit.
+//
+//	Every thread appends finished zones to its own buffer, so
+//	recording a zone never takes a lock. The buffers are written
+//	out as "complete" trace events, which chrome://tracing and
+//	https://ui.perfetto.dev show as a nested timeline per thread.
+//
+
+#ifdef CRISPY_PROFILER
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <fmt/printf.h>
+
+#include "i_system.hpp"
+#include "m_misc.hpp"
+#include "m_profile.hpp"
+
+// per thread, about 100 MB of events
+constexpr size_t MAXPROFILEEVENTS = 1 << 22;
+
+struct profile_event_t {
+  const char * name;
+  int64_t      start;    // ns since M_ProfileStart()
+  int64_t      duration; // ns
+};
+
+struct profile_thread_t {
+  int                          tid;
+  std::vector<profile_event_t> events;
+};
+
+static std::atomic<bool>                              profiling;
+static char *                                         profile_filename;
+static std::chrono::steady_clock::time_point          profile_epoch;
+static std::mutex                                     profile_mutex;
+static std::vector<std::unique_ptr<profile_thread_t>> profile_threads;
+static std::atomic<int64_t>                           profile_dropped;
+
+static int64_t ProfileNow() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - profile_epoch).count();
+}
+
+static profile_thread_t * ProfileThread() {
+  thread_local profile_thread_t * thread = nullptr;
+
+  if (thread == nullptr) {
+    std::lock_guard<std::mutex> lock(profile_mutex);
+
+    thread      = profile_threads.emplace_back(std::make_unique<profile_thread_t>()).get();
+    thread->tid = static_cast<int>(profile_threads.size());
+  }
+
+  return thread;
+}
+
+profile_zone_t::profile_zone_t(const char * name_param)
+    : name(name_param)
+    , start(profiling ? ProfileNow() : -1) {
+}
+
+profile_zone_t::~profile_zone_t() {
+  if (start < 0 || !profiling) {
+    return;
+  }
+
+  profile_thread_t * thread = ProfileThread();
+
+  if (thread->events.size() >= MAXPROFILEEVENTS) {
+    profile_dropped++;
+    return;
+  }
+
+  thread->events.push_back({ name, start, ProfileNow() - start });
+}
+
+// Called at exit. Worker threads are idle by then; zones they
+// would still finish are not recorded once profiling is cleared.
+
+static void M_ProfileWrite() {
+  profiling = false;
+
+  FILE * handle = fopen(profile_filename, "w");
+
+  if (handle == nullptr) {
+    fmt::fprintf(stderr, "M_ProfileWrite: Couldn't open %s\n", profile_filename);
+    return;
+  }
+
+  const char * separator = "";
+  size_t       count     = 0;
+
+  fprintf(handle, "{\"traceEvents\":[\n");
+
+  std::lock_guard<std::mutex> lock(profile_mutex);
+
+  for (const auto & thread : profile_threads) {
+    for (const profile_event_t & event : thread->events) {
+      fprintf(handle, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", separator, event.name, thread->tid, static_cast<double>(event.start) / 1000.0, static_cast<double>(event.duration) / 1000.0);
+      separator = ",\n";
+      count++;
+    }
+  }
+
+  fprintf(handle, "\n],\"displayTimeUnit\":\"ms\"}\n");
+  fclose(handle);
+
+  fmt::printf("M_ProfileWrite: %d zones written to %s", static_cast<int>(count), profile_filename);
+  if (profile_dropped > 0) {
+    fmt::printf(", %d dropped", static_cast<int>(profile_dropped));
+  }
+  fmt::printf(".\n");
+}
+
+void M_ProfileStart(const char * filename) {
+  profile_filename = M_StringDuplicate(filename);
+  profile_epoch    = std::chrono::steady_clock::now();
+  profiling        = true;
+
+  I_AtExit(M_ProfileWrite, true);
+}
+
+#endif
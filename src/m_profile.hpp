@@ -0,0 +1,53 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Scoped profiler zones, written as a Chrome trace on exit.
+//
+//	Only compiled in when CRISPY_PROFILER is defined (cmake
+//	-DENABLE_PROFILER=ON). Otherwise PROFILE_ZONE expands to nothing.
+//
+
+#pragma once
+
+#ifdef CRISPY_PROFILER
+
+#include <cstdint>
+
+// Start recording zones, the trace is written to filename at exit.
+void M_ProfileStart(const char * filename);
+
+class profile_zone_t {
+public:
+  explicit profile_zone_t(const char * name);
+  ~profile_zone_t();
+
+  profile_zone_t(const profile_zone_t &)             = delete;
+  profile_zone_t & operator=(const profile_zone_t &) = delete;
+
+private:
+  const char * name;
+  int64_t      start;
+};
+
+#define PROFILE_ZONE_CAT2(a, b) a##b
+#define PROFILE_ZONE_CAT(a, b)  PROFILE_ZONE_CAT2(a, b)
+
+// Time the rest of the enclosing scope. name must be a string literal.
+#define PROFILE_ZONE(name) const profile_zone_t PROFILE_ZONE_CAT(profile_zone_, __LINE__)(name)
+
+#else
+
+#define PROFILE_ZONE(name)
+
+#endif
@@ -27,6 +27,7 @@
 #include "i_timer.hpp"
 #include "m_argv.hpp"
 #include "m_misc.hpp"
+#include "m_profile.hpp"
 
 #include "net_client.hpp"
 #include "net_common.hpp"
@@ -1616,6 +1617,8 @@ void NET_SV_RegisterWithMaster() {
 // requires
 
 void NET_SV_Run() {
+  PROFILE_ZONE("NET_SV_Run");
+
   if (!server_initialized) {
     return;
   }
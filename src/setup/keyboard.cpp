@@ -397,6 +397,7 @@ static void OtherKeysDialog(void *, void *) {
 
   AddKeyControl(table, "Display last message", &g_m_controls_globals->key_message_refresh);
   AddKeyControl(table, "Finish recording demo", &g_m_controls_globals->key_demo_quit);
+  AddKeyControl(table, "Rewind demo playback", &g_m_controls_globals->key_demo_rewind);
 
   AddSectionLabel(table, "Map", true);
   AddKeyControl(table, "Toggle map", &g_m_controls_globals->key_map_toggle);
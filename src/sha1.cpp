@@ -31,9 +31,17 @@
  */
 
 #include <cstring>
+#include <utility>
 
 #include "sha1.hpp"
 
+// [crispy] SHA-NI, picked at run time on x86 CPUs that have it
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define SHA1_SHANI
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
 void SHA1_Init(sha1_context_t * hd) {
   hd->h0      = 0x67452301;
   hd->h1      = 0xefcdab89;
@@ -184,15 +192,136 @@ static void Transform(sha1_context_t * hd, uint8_t * data) {
 }
 #pragma GCC diagnostic pop
 
+#ifdef SHA1_SHANI
+
+static bool HaveSHANI() {
+  unsigned int eax, ebx, ecx, edx;
+
+  // SSSE3 and SSE4.1 for the shuffles, then the SHA extensions
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_SSSE3) || !(ecx & bit_SSE4_1)) {
+    return false;
+  }
+
+  return __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ebx & (1u << 29)) != 0;
+}
+
+#define SHA1_SHANI_TARGET __attribute__((target("sha,ssse3,sse4.1")))
+
+// Four rounds. msg[] holds the last 16 message words, four to a
+// register, and is expanded in place for the rounds to come.
+
+template <int I>
+SHA1_SHANI_TARGET static inline void RoundsSHANI(__m128i & abcd, __m128i & e0, __m128i & e1, __m128i * msg) {
+  __m128i & e    = I % 2 ? e1 : e0;
+  __m128i & next = I % 2 ? e0 : e1;
+
+  if constexpr (I == 0) {
+    e = _mm_add_epi32(e, msg[0]);
+  } else {
+    e = _mm_sha1nexte_epu32(e, msg[I % 4]);
+  }
+
+  next = abcd;
+
+  if constexpr (I >= 3 && I <= 18) {
+    msg[(I + 1) % 4] = _mm_sha1msg2_epu32(msg[(I + 1) % 4], msg[I % 4]);
+  }
+
+  abcd = _mm_sha1rnds4_epu32(abcd, e, I / 5);
+
+  if constexpr (I >= 1 && I <= 16) {
+    msg[(I + 3) % 4] = _mm_sha1msg1_epu32(msg[(I + 3) % 4], msg[I % 4]);
+  }
+
+  if constexpr (I >= 2 && I <= 17) {
+    msg[(I + 2) % 4] = _mm_xor_si128(msg[(I + 2) % 4], msg[I % 4]);
+  }
+}
+
+template <int... I>
+SHA1_SHANI_TARGET static inline void AllRoundsSHANI(__m128i & abcd, __m128i & e0, __m128i & e1, __m128i * msg, std::integer_sequence<int, I...>) {
+  (RoundsSHANI<I>(abcd, e0, e1, msg), ...);
+}
+
+SHA1_SHANI_TARGET static void TransformSHANI(sha1_context_t * hd, const uint8_t * data, size_t nblocks) {
+  const __m128i mask = _mm_set_epi64x(0x0001020304050607LL, 0x08090a0b0c0d0e0fLL);
+
+  __m128i abcd = _mm_set_epi32(static_cast<int>(hd->h0), static_cast<int>(hd->h1), static_cast<int>(hd->h2), static_cast<int>(hd->h3));
+  __m128i e0   = _mm_set_epi32(static_cast<int>(hd->h4), 0, 0, 0);
+  __m128i e1;
+  __m128i msg[4];
+
+  for (; nblocks > 0; --nblocks, data += 64) {
+    const __m128i abcd_save = abcd;
+    const __m128i e0_save   = e0;
+
+    for (int i = 0; i < 4; i++) {
+      msg[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 16 * i)), mask);
+    }
+
+    AllRoundsSHANI(abcd, e0, e1, msg, std::make_integer_sequence<int, 20>());
+
+    e0   = _mm_sha1nexte_epu32(e0, e0_save);
+    abcd = _mm_add_epi32(abcd, abcd_save);
+  }
+
+  hd->h0 = static_cast<uint32_t>(_mm_extract_epi32(abcd, 3));
+  hd->h1 = static_cast<uint32_t>(_mm_extract_epi32(abcd, 2));
+  hd->h2 = static_cast<uint32_t>(_mm_extract_epi32(abcd, 1));
+  hd->h3 = static_cast<uint32_t>(_mm_extract_epi32(abcd, 0));
+  hd->h4 = static_cast<uint32_t>(_mm_extract_epi32(e0, 3));
+}
+
+#endif
+
+bool SHA1_TransformSupported(sha1_transform_t transform) {
+#ifdef SHA1_SHANI
+  if (transform == sha1_transform_t::shani) {
+    static const bool shani = HaveSHANI();
+    return shani;
+  }
+#endif
+
+  return transform == sha1_transform_t::portable;
+}
+
+static sha1_transform_t transform = SHA1_TransformSupported(sha1_transform_t::shani) ? sha1_transform_t::shani : sha1_transform_t::portable;
+
+sha1_transform_t SHA1_GetTransform() {
+  return transform;
+}
+
+void SHA1_SetTransform(sha1_transform_t new_transform) {
+  if (SHA1_TransformSupported(new_transform)) {
+    transform = new_transform;
+  }
+}
+
+// [crispy] Run whole 64 byte blocks through the transform
+
+static void TransformBlocks(sha1_context_t * hd, uint8_t * data, size_t nblocks) {
+#ifdef SHA1_SHANI
+  if (transform == sha1_transform_t::shani) {
+    TransformSHANI(hd, data, nblocks);
+    hd->nblocks += static_cast<uint32_t>(nblocks);
+    return;
+  }
+#endif
+
+  for (; nblocks > 0; --nblocks, data += 64) {
+    Transform(hd, data);
+    hd->nblocks++;
+  }
+}
+
 /* Update the message digest with the contents
  * of INBUF with length INLEN.
  */
 void SHA1_Update(sha1_context_t * hd, uint8_t * inbuf, size_t inlen) {
   if (hd->count == 64) {
     /* flush the buffer */
-    Transform(hd, hd->buf);
+    TransformBlocks(hd, hd->buf, 1);
     hd->count = 0;
-    hd->nblocks++;
   }
   if (!inbuf)
     return;
@@ -204,12 +333,11 @@ void SHA1_Update(sha1_context_t * hd, uint8_t * inbuf, size_t inlen) {
       return;
   }
 
-  while (inlen >= 64) {
-    Transform(hd, inbuf);
+  if (inlen >= 64) {
+    TransformBlocks(hd, inbuf, inlen / 64);
     hd->count = 0;
-    hd->nblocks++;
-    inlen -= 64;
-    inbuf += 64;
+    inbuf += inlen & ~static_cast<size_t>(63);
+    inlen &= 63;
   }
   for (; inlen && hd->count < 64; inlen--)
     hd->buf[hd->count++] = *inbuf++;
@@ -282,7 +410,7 @@ void SHA1_Final(sha1_digest_t digest, sha1_context_t * hd) {
   hd->buf[61] = static_cast<uint8_t>(lsb >> 16);
   hd->buf[62] = static_cast<uint8_t>(lsb >> 8);
   hd->buf[63] = static_cast<uint8_t>(lsb);
-  Transform(hd, hd->buf);
+  TransformBlocks(hd, hd->buf, 1);
 
   p = hd->buf;
 
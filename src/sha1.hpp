@@ -34,3 +34,16 @@ void SHA1_Update(sha1_context_t * context, uint8_t * buf, size_t len);
 void SHA1_Final(sha1_digest_t digest, sha1_context_t * context);
 void SHA1_UpdateInt32(sha1_context_t * context, unsigned int val);
 void SHA1_UpdateString(sha1_context_t * context, char * str);
+
+// [crispy] The block transforms SHA1_Update() picks from: the portable
+// one, and the one using the x86 SHA extensions. The fastest the CPU
+// supports is used unless the tests select another.
+enum class sha1_transform_t
+{
+  portable,
+  shani
+};
+
+bool             SHA1_TransformSupported(sha1_transform_t transform);
+sha1_transform_t SHA1_GetTransform();
+void             SHA1_SetTransform(sha1_transform_t transform);
@@ -16,6 +16,9 @@
 //       Generate a checksum of the WAD directory.
 //
 
+#include <cstring>
+#include <vector>
+
 #include "w_checksum.hpp"
 #include "i_system.hpp"
 #include "m_misc.hpp"
@@ -26,8 +29,16 @@ static wad_file_t ** open_wadfiles     = nullptr;
 static int           num_open_wadfiles = 0;
 
 static int GetFileNumber(wad_file_t * handle) {
+  // [crispy] lumps of a file are mostly together, try the last one first
+  static int last = 0;
+
+  if (last < num_open_wadfiles && open_wadfiles[last] == handle) {
+    return last;
+  }
+
   for (int i = 0; i < num_open_wadfiles; ++i) {
     if (open_wadfiles[i] == handle) {
+      last = i;
       return i;
     }
   }
@@ -42,21 +53,34 @@ static int GetFileNumber(wad_file_t * handle) {
   int result = num_open_wadfiles;
   ++num_open_wadfiles;
 
+  last = result;
   return result;
 }
 
-static void ChecksumAddLump(sha1_context_t * sha1_context, lumpinfo_t * lump) {
-  char buf[9];
+static void AppendInt32(std::vector<uint8_t> & buf, unsigned int val) {
+  // big endian, as SHA1_UpdateInt32() does
+  buf.push_back(static_cast<uint8_t>((val >> 24) & 0xff));
+  buf.push_back(static_cast<uint8_t>((val >> 16) & 0xff));
+  buf.push_back(static_cast<uint8_t>((val >> 8) & 0xff));
+  buf.push_back(static_cast<uint8_t>(val & 0xff));
+}
+
+// [crispy] The same bytes SHA1_UpdateString() and SHA1_UpdateInt32()
+// would add for the lump, so that the checksum stays the same
 
-  M_StringCopy(buf, lump->name, sizeof(buf));
-  SHA1_UpdateString(sha1_context, buf);
-  SHA1_UpdateInt32(sha1_context, static_cast<unsigned int>(GetFileNumber(lump->wad_file)));
-  SHA1_UpdateInt32(sha1_context, static_cast<unsigned int>(lump->position));
-  SHA1_UpdateInt32(sha1_context, static_cast<unsigned int>(lump->size));
+static void ChecksumAddLump(std::vector<uint8_t> & buf, lumpinfo_t * lump) {
+  char name[9];
+
+  M_StringCopy(name, lump->name, sizeof(name));
+  buf.insert(buf.end(), name, name + strlen(name) + 1);
+  AppendInt32(buf, static_cast<unsigned int>(GetFileNumber(lump->wad_file)));
+  AppendInt32(buf, static_cast<unsigned int>(lump->position));
+  AppendInt32(buf, static_cast<unsigned int>(lump->size));
 }
 
 void W_Checksum(sha1_digest_t digest) {
-  sha1_context_t sha1_context;
+  sha1_context_t       sha1_context;
+  std::vector<uint8_t> buf;
 
   SHA1_Init(&sha1_context);
 
@@ -64,10 +88,14 @@ void W_Checksum(sha1_digest_t digest) {
 
   // Go through each entry in the WAD directory, adding information
   // about each entry to the SHA1 hash.
+  // [crispy] in one go, rather than a few bytes at a time
+
+  buf.reserve(numlumps * (9 + 3 * 4));
 
   for (size_t i = 0; i < numlumps; ++i) {
-    ChecksumAddLump(&sha1_context, lumpinfo[i]);
+    ChecksumAddLump(buf, lumpinfo[i]);
   }
 
+  SHA1_Update(&sha1_context, buf.data(), buf.size());
   SHA1_Final(digest, &sha1_context);
 }
@@ -16,6 +16,10 @@
 //	WAD I/O functions.
 //
 
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
 #include "w_file.hpp"
 #include "m_argv.hpp"
 
@@ -29,6 +33,13 @@ extern wad_file_class_t win32_wad_file;
 extern wad_file_class_t posix_wad_file;
 #endif
 
+#ifdef HAVE_LIBZ
+extern wad_file_class_t zip_wad_file;
+#endif
+
+// [crispy] serializes reads of files that are not mapped
+static std::mutex read_mutex;
+
 static wad_file_class_t * wad_file_classes[] = {
 #ifdef _WIN32
   &win32_wad_file,
@@ -40,14 +51,25 @@ static wad_file_class_t * wad_file_classes[] = {
 };
 
 wad_file_t * W_OpenFile(cstring_view path) {
+#ifdef HAVE_LIBZ
+  // [crispy] zip archives are only read through their own class,
+  // which turns down anything else
+
+  wad_file_t * zip = zip_wad_file.OpenFile(path);
+
+  if (zip != nullptr) {
+    return zip;
+  }
+#endif
+
   //!
   // @category obscure
   //
-  // Use the OS's virtual memory subsystem to map WAD files
-  // directly into memory.
+  // Don't use the OS's virtual memory subsystem to map WAD files
+  // into memory, read lumps with the C standard library instead.
   //
 
-  if (!M_CheckParm("-mmap")) {
+  if (M_CheckParm("-nommap")) {
     return stdc_wad_file.OpenFile(path);
   }
 
@@ -71,5 +93,35 @@ void W_CloseFile(wad_file_t * wad) {
 }
 
 size_t W_Read(wad_file_t * wad, unsigned int offset, void * buffer, size_t buffer_len) {
+  // [crispy] copy straight out of a mapped file
+  if (wad->mapped != nullptr) {
+    if (offset >= wad->length) {
+      return 0;
+    }
+
+    buffer_len = std::min(buffer_len, static_cast<size_t>(wad->length - offset));
+    std::memcpy(buffer, wad->mapped + offset, buffer_len);
+
+    return buffer_len;
+  }
+
+  // [crispy] the game and the w_prefetch.cpp reader thread share
+  // the file position
+  std::lock_guard<std::mutex> lock(read_mutex);
+
   return wad->file_class->Read(wad, offset, buffer, buffer_len);
 }
+
+void W_ReadBatch(wad_file_t * wad, wad_read_t * reads, int count) {
+  if (wad->mapped != nullptr || wad->file_class->ReadBatch == nullptr) {
+    for (int i = 0; i < count; ++i) {
+      reads[i].bytes_read = W_Read(wad, reads[i].offset, reads[i].buffer, reads[i].length);
+    }
+
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(read_mutex);
+
+  wad->file_class->ReadBatch(wad, reads, count);
+}
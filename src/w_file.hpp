@@ -25,6 +25,14 @@
 
 using wad_file_t = struct _wad_file_s;
 
+// [crispy] One range of a batched read, see W_ReadBatch().
+struct wad_read_t {
+  unsigned int offset;
+  void *       buffer;
+  size_t       length;
+  size_t       bytes_read; // filled in by the read
+};
+
 struct wad_file_class_t {
   // Open a file for reading.
   wad_file_t * (*OpenFile)(cstring_view path);
@@ -35,6 +43,11 @@ struct wad_file_class_t {
   // Read data from the specified position in the file into the
   // provided buffer.  Returns the number of bytes read.
   size_t (*Read)(wad_file_t * file, unsigned int offset, void * buffer, size_t buffer_len);
+
+  // [crispy] Read a batch of ranges, sorted by offset, filling in
+  // bytes_read for each. Ranges that follow each other in the file
+  // may be read with a single call. nullptr to use Read for each.
+  void (*ReadBatch)(wad_file_t * file, wad_read_t * reads, int count);
 };
 
 struct _wad_file_s {
@@ -43,7 +56,8 @@ struct _wad_file_s {
 
   // If this is nullptr, the file cannot be mapped into memory.  If this
   // is non-NULL, it is a pointer to the mapped file.
-  uint8_t * mapped;
+  // [crispy] The mapping is read-only.
+  const uint8_t * mapped;
 
   // Length of the file, in bytes.
   unsigned int length;
@@ -66,3 +80,8 @@ void W_CloseFile(wad_file_t * wad);
 // Returns the number of bytes read.
 
 size_t W_Read(wad_file_t * wad, unsigned int offset, void * buffer, size_t buffer_len);
+
+// [crispy] Read a batch of ranges, sorted by offset, from the file.
+// The number of bytes read into each is stored in its bytes_read.
+
+void W_ReadBatch(wad_file_t * wad, wad_read_t * reads, int count);
@@ -18,15 +18,19 @@
 
 #ifdef HAVE_MMAP
 
-#include <errno.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
 #include <fcntl.h>
-#include <string.h>
 #include <sys/mman.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include <fmt/printf.h>
 
 #include "m_misc.hpp"
+#include "memory.hpp"
 #include "w_file.hpp"
 #include "z_zone.hpp"
 
@@ -38,40 +42,34 @@ struct posix_wad_file_t {
 extern wad_file_class_t posix_wad_file;
 
 static void MapFile(posix_wad_file_t * wad, cstring_view filename) {
-  void * result;
-  int    protection;
-  int    flags;
-
-  // Mapped area can be read and written to.  Ideally
-  // this should be read-only, as none of the Doom code should
-  // change the WAD files after being read.  However, there may
-  // be code lurking in the source that does.
+  // [crispy] Mapped area is read-only. Lumps that the Doom code
+  // writes to are copied into zone memory by W_CacheLumpNum(),
+  // W_LumpView() returns pointers straight into the mapping.
 
-  protection = PROT_READ | PROT_WRITE;
+  int protection = PROT_READ;
 
   // Writes to the mapped area result in private changes that are
   // *not* written to disk.
 
-  flags = MAP_PRIVATE;
+  int flags = MAP_PRIVATE;
 
-  result = mmap(nullptr, wad->wad.length, protection, flags, wad->handle, 0);
+  void * result = mmap(nullptr, wad->wad.length, protection, flags, wad->handle, 0);
 
-  wad->wad.mapped = result;
-
-  if (result == nullptr) {
-    fmt::fprintf(stderr, "W_POSIX_OpenFile: Unable to mmap() %s - %s\n", filename, strerror(errno));
+  if (result == MAP_FAILED) {
+    fmt::fprintf(stderr, "W_POSIX_OpenFile: Unable to mmap() %s - %s\n", filename.c_str(), strerror(errno));
+    wad->wad.mapped = nullptr;
+    return;
   }
+
+  wad->wad.mapped = static_cast<const uint8_t *>(result);
 }
 
-unsigned int GetFileLength(int handle) {
-  return lseek(handle, 0, SEEK_END);
+static unsigned int GetFileLength(int handle) {
+  return static_cast<unsigned int>(lseek(handle, 0, SEEK_END));
 }
 
 static wad_file_t * W_POSIX_OpenFile(cstring_view path) {
-  posix_wad_file_t * result;
-  int                handle;
-
-  handle = open(path, 0);
+  int handle = open(path.c_str(), O_RDONLY);
 
   if (handle < 0) {
     return nullptr;
@@ -79,26 +77,32 @@ static wad_file_t * W_POSIX_OpenFile(cstring_view path) {
 
   // Create a new posix_wad_file_t to hold the file handle.
 
-  result                 = Z_Malloc(sizeof(posix_wad_file_t), PU_STATIC, 0);
-  result->wad.file_class = &posix_wad_file;
-  result->wad.length     = GetFileLength(handle);
-  result->wad.path       = M_StringDuplicate(path);
-  result->handle         = handle;
+  posix_wad_file_t * result = zmalloc<posix_wad_file_t *>(sizeof(posix_wad_file_t), PU_STATIC, 0);
+  result->wad.file_class    = &posix_wad_file;
+  result->wad.mapped        = nullptr;
+  result->wad.length        = GetFileLength(handle);
+  result->wad.path          = M_StringDuplicate(path);
+  result->handle            = handle;
 
   // Try to map the file into memory with mmap:
+  // [crispy] mmap() of an empty file fails
 
-  MapFile(result, path);
+  if (result->wad.length > 0) {
+    MapFile(result, path);
+  }
 
   return &result->wad;
 }
 
 static void W_POSIX_CloseFile(wad_file_t * wad) {
-  posix_wad_file_t * posix_wad;
-
-  posix_wad = (posix_wad_file_t *)wad;
+  auto * posix_wad = reinterpret_cast<posix_wad_file_t *>(wad);
 
   // If mapped, unmap it.
 
+  if (posix_wad->wad.mapped != nullptr) {
+    munmap(const_cast<uint8_t *>(posix_wad->wad.mapped), posix_wad->wad.length);
+  }
+
   // Close the file
 
   close(posix_wad->handle);
@@ -107,28 +111,24 @@ static void W_POSIX_CloseFile(wad_file_t * wad) {
 
 // Read data from the specified position in the file into the
 // provided buffer.  Returns the number of bytes read.
+// [crispy] pread() leaves the file position alone, no seek needed.
 
 size_t W_POSIX_Read(wad_file_t * wad, unsigned int offset, void * buffer, size_t buffer_len) {
-  posix_wad_file_t * posix_wad;
-  byte *             byte_buffer;
-  size_t             bytes_read;
-  int                result;
-
-  posix_wad = (posix_wad_file_t *)wad;
-
-  // Jump to the specified position in the file.
-
-  lseek(posix_wad->handle, offset, SEEK_SET);
+  auto * posix_wad = reinterpret_cast<posix_wad_file_t *>(wad);
 
   // Read into the buffer.
 
-  bytes_read  = 0;
-  byte_buffer = buffer;
+  size_t bytes_read  = 0;
+  auto * byte_buffer = static_cast<uint8_t *>(buffer);
 
   while (buffer_len > 0) {
-    result = read(posix_wad->handle, byte_buffer, buffer_len);
+    ssize_t result = pread(posix_wad->handle, byte_buffer, buffer_len, static_cast<off_t>(offset + bytes_read));
 
     if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
       perror("W_POSIX_Read");
       break;
     } else if (result == 0) {
@@ -138,17 +138,66 @@ size_t W_POSIX_Read(wad_file_t * wad, unsigned int offset, void * buffer, size_t
     // Successfully read some bytes
 
     byte_buffer += result;
-    buffer_len -= result;
-    bytes_read += result;
+    buffer_len -= static_cast<size_t>(result);
+    bytes_read += static_cast<size_t>(result);
   }
 
   return bytes_read;
 }
 
+// [crispy] Read each run of ranges that follow each other in the
+// file, such as the lumps of a map, with one preadv() call.
+
+#ifdef HAVE_PREADV
+constexpr int MAXBATCHRUN = 64;
+#endif
+
+static void W_POSIX_ReadBatch(wad_file_t * wad, wad_read_t * reads, int count) {
+#ifdef HAVE_PREADV
+  auto * posix_wad = reinterpret_cast<posix_wad_file_t *>(wad);
+
+  for (int i = 0; i < count;) {
+    struct iovec iov[MAXBATCHRUN];
+    size_t       total = 0;
+    int          run   = 0;
+
+    do {
+      iov[run].iov_base = reads[i + run].buffer;
+      iov[run].iov_len  = reads[i + run].length;
+      total += reads[i + run].length;
+      ++run;
+    } while (i + run < count && run < MAXBATCHRUN
+             && reads[i + run].offset == reads[i + run - 1].offset + reads[i + run - 1].length);
+
+    ssize_t    result     = preadv(posix_wad->handle, iov, run, static_cast<off_t>(reads[i].offset));
+    size_t     got        = result > 0 ? static_cast<size_t>(result) : 0;
+    const bool short_read = got < total;
+
+    // Hand out what was read, a short read is finished range by range
+
+    for (int j = i; j < i + run; ++j) {
+      reads[j].bytes_read = std::min(got, reads[j].length);
+      got -= reads[j].bytes_read;
+
+      if (short_read && reads[j].bytes_read < reads[j].length) {
+        reads[j].bytes_read += W_POSIX_Read(wad, reads[j].offset + static_cast<unsigned int>(reads[j].bytes_read), static_cast<uint8_t *>(reads[j].buffer) + reads[j].bytes_read, reads[j].length - reads[j].bytes_read);
+      }
+    }
+
+    i += run;
+  }
+#else
+  for (int i = 0; i < count; ++i) {
+    reads[i].bytes_read = W_POSIX_Read(wad, reads[i].offset, reads[i].buffer, reads[i].length);
+  }
+#endif
+}
+
 wad_file_class_t posix_wad_file = {
   W_POSIX_OpenFile,
   W_POSIX_CloseFile,
   W_POSIX_Read,
+  W_POSIX_ReadBatch,
 };
 
 #endif /* #ifdef HAVE_MMAP */
@@ -71,8 +71,26 @@ size_t W_StdC_Read(wad_file_t * wad, unsigned int offset, void * buffer, size_t
   return result;
 }
 
+// [crispy] Only seek where a range does not follow the previous one,
+// so that reads of adjacent lumps come out of the stdio buffer.
+
+static void W_StdC_ReadBatch(wad_file_t * wad, wad_read_t * reads, int count) {
+  auto * stdc_wad = reinterpret_cast<stdc_wad_file_t *>(wad);
+  long   position = -1;
+
+  for (int i = 0; i < count; ++i) {
+    if (position != static_cast<long>(reads[i].offset)) {
+      fseek(stdc_wad->fstream, reads[i].offset, SEEK_SET);
+    }
+
+    reads[i].bytes_read = fread(reads[i].buffer, 1, reads[i].length, stdc_wad->fstream);
+    position            = static_cast<long>(reads[i].offset + reads[i].bytes_read);
+  }
+}
+
 wad_file_class_t stdc_wad_file = {
   W_StdC_OpenFile,
   W_StdC_CloseFile,
   W_StdC_Read,
+  W_StdC_ReadBatch,
 };
@@ -49,7 +49,7 @@ extern wad_file_class_t win32_wad_file;
 static void MapFile(win32_wad_file_t * wad, cstring_view filename) {
   wad->handle_map = CreateFileMapping(wad->handle,
                                       nullptr,
-                                      PAGE_WRITECOPY,
+                                      PAGE_READONLY,
                                       0,
                                       0,
                                       nullptr);
@@ -61,11 +61,12 @@ static void MapFile(win32_wad_file_t * wad, cstring_view filename) {
     return;
   }
 
-  wad->wad.mapped = static_cast<uint8_t *>(MapViewOfFile(wad->handle_map,
-                                                         FILE_MAP_COPY,
-                                                         0,
-                                                         0,
-                                                         0));
+  // [crispy] read-only, lumps are copied out by W_CacheLumpNum()
+  wad->wad.mapped = static_cast<const uint8_t *>(MapViewOfFile(wad->handle_map,
+                                                               FILE_MAP_READ,
+                                                               0,
+                                                               0,
+                                                               0));
 
   if (wad->wad.mapped == nullptr) {
     fmt::fprintf(stderr, "W_Win32_OpenFile: Unable to MapViewOfFile() for %s\n", filename.c_str());
@@ -166,6 +167,7 @@ wad_file_class_t win32_wad_file = {
   W_Win32_OpenFile,
   W_Win32_CloseFile,
   W_Win32_Read,
+  nullptr,
 };
 
 #endif /* #ifdef _WIN32 */
@@ -0,0 +1,614 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	[crispy] PK3/zip archives with stored or deflated entries.
+//
+//	The archive is presented as a PWAD: a header and a directory
+//	built from the zip central directory, followed by the entries
+//	in their uncompressed form. W_AddFile() reads it like any
+//	other WAD, and an entry is only inflated when a lump in it is
+//	read. The last entry inflated for a partial read is kept, so
+//	reading a lump in pieces doesn't inflate it again.
+//
+//	Entries in flats/ and sprites/ are put between F_START/F_END
+//	and S_START/S_END markers, those at the top level and in
+//	graphics/, patches/, sounds/ and music/ keep the order of the
+//	archive. Lumps are named after the file name of the entry,
+//	without its extension. A WAD file in maps/ is expanded into its
+//	lumps, with the first one named after the file, as ZDoom does.
+//	Other directories, and pictures in formats other than Doom's
+//	own, are left out; the engine has no use for them.
+//
+
+#ifdef HAVE_LIBZ
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <fmt/printf.h>
+#include <zlib.h>
+
+#include "i_system.hpp"
+#include "m_misc.hpp"
+#include "memory.hpp"
+#include "w_file.hpp"
+#include "z_zone.hpp"
+
+constexpr uint32_t ZIP_LOCAL_SIG   = 0x04034b50;
+constexpr uint32_t ZIP_CENTRAL_SIG = 0x02014b50;
+constexpr uint32_t ZIP_END_SIG     = 0x06054b50;
+
+constexpr int ZIP_STORED   = 0;
+constexpr int ZIP_DEFLATED = 8;
+
+// end of central directory record, without the comment
+constexpr unsigned int ZIP_END_SIZE = 22;
+
+struct zip_lump_t {
+  char         name[8];
+  unsigned int position;    // in the WAD image
+  unsigned int size;        // uncompressed
+  unsigned int offset;      // in the uncompressed entry, for maps/*.wad
+  unsigned int entry_size;  // uncompressed size of the whole entry
+  unsigned int csize;       // compressed
+  unsigned int local;       // offset of the local header
+  long         data;        // offset of the data, -1 until known
+  uint32_t     crc;
+  int          method;
+};
+
+struct zip_wad_file_t {
+  wad_file_t   wad;
+  FILE *       fstream;
+  zip_lump_t * lumps;
+  int          numlumps;
+  uint8_t *    header; // WAD header and directory
+  unsigned int header_size;
+
+  // last entry inflated for a partial read, by its local header
+  long      cached_entry;
+  uint8_t * cached_data;
+};
+
+extern wad_file_class_t zip_wad_file;
+
+static bool ReadEntry(zip_wad_file_t * zip, zip_lump_t * lump, uint8_t * dest);
+
+static uint16_t ReadU16(const uint8_t * p) {
+  return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+static uint32_t ReadU32(const uint8_t * p) {
+  return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8)
+         | (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+static void WriteU32(uint8_t * p, uint32_t value) {
+  p[0] = static_cast<uint8_t>(value);
+  p[1] = static_cast<uint8_t>(value >> 8);
+  p[2] = static_cast<uint8_t>(value >> 16);
+  p[3] = static_cast<uint8_t>(value >> 24);
+}
+
+static bool ReadAt(FILE * fstream, long offset, void * buffer, size_t length) {
+  return fseek(fstream, offset, SEEK_SET) == 0 && fread(buffer, 1, length, fstream) == length;
+}
+
+// Name a lump after the file name of the entry: "sprites/trooa1.png"
+// is TROOA1.
+
+static void LumpName(char * dest, const char * path, size_t path_len) {
+  const char * base = path;
+
+  for (size_t i = 0; i < path_len; ++i) {
+    if (path[i] == '/') {
+      base = path + i + 1;
+    }
+  }
+
+  std::memset(dest, 0, 8);
+
+  for (size_t i = 0; i < 8 && base + i < path + path_len && base[i] != '.'; ++i) {
+    dest[i] = static_cast<char>(toupper(base[i]));
+  }
+}
+
+enum zip_section_t
+{
+  ZIP_NORMAL,
+  ZIP_FLATS,
+  ZIP_SPRITES,
+  ZIP_MAPWAD,
+  ZIP_UNUSED,
+};
+
+// Pictures the engine can't draw, it only reads Doom's own formats
+static const char * const unused_extensions[] = { "png", "jpg", "jpeg", "gif", "bmp", "tga", "pcx", "dds" };
+
+static zip_section_t EntrySection(const char * path, size_t path_len) {
+  const char * slash     = static_cast<const char *>(memchr(path, '/', path_len));
+  const char * extension = nullptr;
+
+  for (size_t i = path_len; i-- > 0 && path[i] != '/';) {
+    if (path[i] == '.') {
+      extension = path + i + 1;
+      break;
+    }
+  }
+
+  const size_t extension_len = extension != nullptr ? static_cast<size_t>(path + path_len - extension) : 0;
+
+  auto has_extension = [extension, extension_len](const char * ext) {
+    return extension_len == strlen(ext) && !strncasecmp(extension, ext, extension_len);
+  };
+
+  for (const char * ext : unused_extensions) {
+    if (has_extension(ext)) {
+      return ZIP_UNUSED;
+    }
+  }
+
+  if (slash == nullptr) {
+    return ZIP_NORMAL;
+  }
+
+  const size_t dir_len = static_cast<size_t>(slash - path);
+
+  auto in_dir = [path, dir_len](const char * dir) {
+    return dir_len == strlen(dir) && !strncasecmp(path, dir, dir_len);
+  };
+
+  if (in_dir("flats")) {
+    return ZIP_FLATS;
+  }
+
+  if (in_dir("sprites")) {
+    return ZIP_SPRITES;
+  }
+
+  if (in_dir("maps")) {
+    return has_extension("wad") ? ZIP_MAPWAD : ZIP_UNUSED;
+  }
+
+  if (in_dir("graphics") || in_dir("patches") || in_dir("sounds") || in_dir("music")) {
+    return ZIP_NORMAL;
+  }
+
+  return ZIP_UNUSED;
+}
+
+// Add the lumps of a WAD file in maps/, as views into the inflated
+// entry. The map marker is named after the file: maps/MAP01.wad
+// holds MAP01, whatever it is called inside.
+
+static void AddMapWad(zip_wad_file_t * zip, zip_lump_t entry, const char * path, size_t path_len, std::vector<zip_lump_t> & lumps) {
+  auto * data = static_cast<uint8_t *>(malloc(std::max(entry.entry_size, 1u)));
+
+  bool ok = data != nullptr && ReadEntry(zip, &entry, data) && entry.entry_size >= 12
+            && (!memcmp(data, "PWAD", 4) || !memcmp(data, "IWAD", 4));
+
+  const size_t first = lumps.size();
+
+  if (ok) {
+    const uint32_t numlumps = ReadU32(data + 4);
+    const uint32_t dir      = ReadU32(data + 8);
+
+    ok = dir <= entry.entry_size && numlumps <= (entry.entry_size - dir) / 16;
+
+    for (uint32_t i = 0; ok && i < numlumps; ++i) {
+      const uint8_t * dir_entry = data + dir + 16 * i;
+      const uint32_t  filepos   = ReadU32(dir_entry);
+      const uint32_t  size      = ReadU32(dir_entry + 4);
+
+      if (filepos > entry.entry_size || size > entry.entry_size - filepos) {
+        ok = false;
+        break;
+      }
+
+      zip_lump_t & lump = lumps.emplace_back(entry);
+      lump.offset       = filepos;
+      lump.size         = size;
+      std::memcpy(lump.name, dir_entry + 8, 8);
+
+      if (i == 0) {
+        LumpName(lump.name, path, path_len);
+      }
+    }
+  }
+
+  if (!ok) {
+    lumps.resize(first);
+    fmt::fprintf(stderr, "W_Zip_OpenFile: skipping %.*s, it is not a valid WAD file\n", static_cast<int>(path_len), path);
+  }
+
+  free(data);
+}
+
+// Find the end of central directory record, it's followed by a
+// comment of up to 64 KB.
+
+static bool FindCentralDirectory(FILE * fstream, unsigned int length, uint8_t * end) {
+  if (length < ZIP_END_SIZE) {
+    return false;
+  }
+
+  const unsigned int search = std::min(length, ZIP_END_SIZE + 0xffff);
+  auto *             tail   = static_cast<uint8_t *>(malloc(search));
+
+  bool found = false;
+
+  if (tail != nullptr && ReadAt(fstream, static_cast<long>(length - search), tail, search)) {
+    for (unsigned int i = search - ZIP_END_SIZE + 1; i-- > 0;) {
+      if (ReadU32(tail + i) == ZIP_END_SIG) {
+        std::memcpy(end, tail + i, ZIP_END_SIZE);
+        found = true;
+        break;
+      }
+    }
+  }
+
+  free(tail);
+
+  return found;
+}
+
+// Build the lump list and the WAD header and directory from the
+// central directory. Returns false if this is not a zip file we
+// can read.
+
+static bool ReadCentralDirectory(zip_wad_file_t * zip, cstring_view path) {
+  uint8_t end[ZIP_END_SIZE];
+
+  if (!FindCentralDirectory(zip->fstream, zip->wad.length, end)) {
+    return false;
+  }
+
+  const int          numentries = ReadU16(end + 10);
+  const unsigned int cd_size    = ReadU32(end + 12);
+  const unsigned int cd_offset  = ReadU32(end + 16);
+
+  if (static_cast<uint64_t>(cd_offset) + cd_size > zip->wad.length) {
+    // split archives and ZIP64 are not supported
+    return false;
+  }
+
+  auto * cd = static_cast<uint8_t *>(malloc(cd_size));
+
+  if (cd == nullptr || !ReadAt(zip->fstream, static_cast<long>(cd_offset), cd, cd_size)) {
+    free(cd);
+    return false;
+  }
+
+  std::vector<zip_lump_t>    entries;
+  std::vector<zip_section_t> sections;
+  int                        numflats  = 0;
+  int                        numsprite = 0;
+
+  const uint8_t * p = cd;
+
+  for (int i = 0; i < numentries; ++i) {
+    if (p + 46 > cd + cd_size || ReadU32(p) != ZIP_CENTRAL_SIG) {
+      fmt::fprintf(stderr, "W_Zip_OpenFile: %s has a damaged central directory\n", path.c_str());
+      break;
+    }
+
+    const int          flags    = ReadU16(p + 8);
+    const int          method   = ReadU16(p + 10);
+    const size_t       name_len = ReadU16(p + 28);
+    const size_t       skip_len = name_len + ReadU16(p + 30) + ReadU16(p + 32);
+    const char *       name     = reinterpret_cast<const char *>(p + 46);
+    const unsigned int usize    = ReadU32(p + 24);
+
+    if (p + 46 + skip_len > cd + cd_size) {
+      break;
+    }
+
+    // skip directories, entries of no use, encrypted entries and
+    // other compression methods
+
+    const zip_section_t section = name_len > 0 && name[name_len - 1] != '/' ? EntrySection(name, name_len) : ZIP_UNUSED;
+
+    if (section != ZIP_UNUSED) {
+      if ((flags & 1) != 0 || (method != ZIP_STORED && method != ZIP_DEFLATED)) {
+        fmt::fprintf(stderr, "W_Zip_OpenFile: skipping %.*s, it is encrypted or compressed with method %d\n", static_cast<int>(name_len), name, method);
+      } else {
+        zip_lump_t lump {};
+
+        LumpName(lump.name, name, name_len);
+        lump.size       = usize;
+        lump.offset     = 0;
+        lump.entry_size = usize;
+        lump.csize      = ReadU32(p + 20);
+        lump.local      = ReadU32(p + 42);
+        lump.data       = -1;
+        lump.crc        = ReadU32(p + 16);
+        lump.method     = method;
+
+        if (section == ZIP_MAPWAD) {
+          AddMapWad(zip, lump, name, name_len, entries);
+        } else {
+          entries.push_back(lump);
+        }
+
+        sections.resize(entries.size(), section == ZIP_MAPWAD ? ZIP_NORMAL : section);
+        numflats += section == ZIP_FLATS;
+        numsprite += section == ZIP_SPRITES;
+      }
+    }
+
+    p += 46 + skip_len;
+  }
+
+  free(cd);
+
+  // Put the entries in WAD order: everything else, then the flats
+  // and the sprites between their markers
+
+  // two extra lumps for the markers of each namespace
+  zip->lumps    = zmalloc<zip_lump_t *>(sizeof(zip_lump_t) * (entries.size() + 4), PU_STATIC, nullptr);
+  zip->numlumps = 0;
+
+  auto add_marker = [zip](const char * name) {
+    zip_lump_t * lump = &zip->lumps[zip->numlumps++];
+
+    std::memset(lump, 0, sizeof(*lump));
+    strncpy(lump->name, name, 8);
+    lump->data = 0;
+  };
+
+  auto add_section = [&](zip_section_t section) {
+    for (size_t i = 0; i < entries.size(); ++i) {
+      if (sections[i] == section) {
+        zip->lumps[zip->numlumps++] = entries[i];
+      }
+    }
+  };
+
+  add_section(ZIP_NORMAL);
+
+  if (numflats > 0) {
+    add_marker("F_START");
+    add_section(ZIP_FLATS);
+    add_marker("F_END");
+  }
+
+  if (numsprite > 0) {
+    add_marker("S_START");
+    add_section(ZIP_SPRITES);
+    add_marker("S_END");
+  }
+
+  // WAD header and directory, then the lump data
+
+  zip->header_size = 12 + 16 * static_cast<unsigned int>(zip->numlumps);
+  zip->header      = zmalloc<uint8_t *>(zip->header_size, PU_STATIC, nullptr);
+
+  std::memcpy(zip->header, "PWAD", 4);
+  WriteU32(zip->header + 4, static_cast<uint32_t>(zip->numlumps));
+  WriteU32(zip->header + 8, 12);
+
+  uint64_t position = zip->header_size;
+
+  for (int i = 0; i < zip->numlumps; ++i) {
+    zip_lump_t * lump = &zip->lumps[i];
+    uint8_t *    dir  = zip->header + 12 + 16 * i;
+
+    lump->position = static_cast<unsigned int>(position);
+    position += lump->size;
+
+    WriteU32(dir, lump->position);
+    WriteU32(dir + 4, lump->size);
+    std::memcpy(dir + 8, lump->name, 8);
+  }
+
+  if (position > 0xffffffffu) {
+    fmt::fprintf(stderr, "W_Zip_OpenFile: %s is larger than 4 GB uncompressed\n", path.c_str());
+    return false;
+  }
+
+  zip->wad.length = static_cast<unsigned int>(position);
+
+  return true;
+}
+
+static void FreeZip(zip_wad_file_t * zip) {
+  if (zip->lumps != nullptr) {
+    Z_Free(zip->lumps);
+  }
+
+  if (zip->header != nullptr) {
+    Z_Free(zip->header);
+  }
+
+  free(zip->cached_data);
+  fclose(zip->fstream);
+  free(zip->wad.path);
+  Z_Free(zip);
+}
+
+static wad_file_t * W_Zip_OpenFile(cstring_view path) {
+  FILE * fstream = fopen(path.c_str(), "rb");
+
+  if (fstream == nullptr) {
+    return nullptr;
+  }
+
+  // Only take files that start like a zip archive
+
+  uint8_t signature[4];
+
+  if (fread(signature, 1, 4, fstream) != 4 || ReadU32(signature) != ZIP_LOCAL_SIG) {
+    fclose(fstream);
+    return nullptr;
+  }
+
+  zip_wad_file_t * result = zmalloc<zip_wad_file_t *>(sizeof(zip_wad_file_t), PU_STATIC, 0);
+  result->wad.file_class  = &zip_wad_file;
+  result->wad.mapped      = nullptr;
+  result->wad.length      = static_cast<unsigned int>(M_FileLength(fstream));
+  result->wad.path        = M_StringDuplicate(path);
+  result->fstream         = fstream;
+  result->lumps           = nullptr;
+  result->numlumps        = 0;
+  result->header          = nullptr;
+  result->header_size     = 0;
+  result->cached_entry    = -1;
+  result->cached_data     = nullptr;
+
+  if (!ReadCentralDirectory(result, path)) {
+    FreeZip(result);
+    return nullptr;
+  }
+
+  return &result->wad;
+}
+
+static void W_Zip_CloseFile(wad_file_t * wad) {
+  FreeZip(reinterpret_cast<zip_wad_file_t *>(wad));
+}
+
+// Read the entry of a lump in full into dest, which holds
+// lump->entry_size bytes.
+// Runs on the w_prefetch.cpp reader thread too, so no zone memory.
+
+static bool ReadEntry(zip_wad_file_t * zip, zip_lump_t * lump, uint8_t * dest) {
+  if (lump->data < 0) {
+    uint8_t local[30];
+
+    if (!ReadAt(zip->fstream, static_cast<long>(lump->local), local, sizeof(local))
+        || ReadU32(local) != ZIP_LOCAL_SIG) {
+      return false;
+    }
+
+    lump->data = static_cast<long>(lump->local) + 30 + ReadU16(local + 26) + ReadU16(local + 28);
+  }
+
+  if (lump->method == ZIP_STORED) {
+    return ReadAt(zip->fstream, lump->data, dest, lump->entry_size);
+  }
+
+  auto * compressed = static_cast<uint8_t *>(malloc(std::max(lump->csize, 1u)));
+
+  if (compressed == nullptr || !ReadAt(zip->fstream, lump->data, compressed, lump->csize)) {
+    free(compressed);
+    return false;
+  }
+
+  z_stream stream {};
+  stream.next_in   = compressed;
+  stream.avail_in  = lump->csize;
+  stream.next_out  = dest;
+  stream.avail_out = lump->entry_size;
+
+  // raw deflate data, no zlib header
+  bool ok = inflateInit2(&stream, -MAX_WBITS) == Z_OK;
+
+  if (ok) {
+    ok = inflate(&stream, Z_FINISH) == Z_STREAM_END && stream.total_out == lump->entry_size;
+    inflateEnd(&stream);
+  }
+
+  free(compressed);
+
+  if (ok && crc32(0, dest, lump->entry_size) != lump->crc) {
+    fmt::fprintf(stderr, "W_Zip_Read: %s: CRC mismatch in lump %.8s\n", zip->wad.path, lump->name);
+  }
+
+  return ok;
+}
+
+size_t W_Zip_Read(wad_file_t * wad, unsigned int offset, void * buffer, size_t buffer_len) {
+  auto * zip        = reinterpret_cast<zip_wad_file_t *>(wad);
+  auto * dest       = static_cast<uint8_t *>(buffer);
+  size_t bytes_read = 0;
+
+  if (offset >= wad->length) {
+    return 0;
+  }
+
+  buffer_len = std::min(buffer_len, static_cast<size_t>(wad->length - offset));
+
+  // The header and directory
+
+  if (offset < zip->header_size) {
+    const size_t n = std::min(buffer_len, static_cast<size_t>(zip->header_size - offset));
+
+    std::memcpy(dest, zip->header + offset, n);
+    bytes_read += n;
+  }
+
+  // The lumps, by their position in the image
+
+  while (bytes_read < buffer_len) {
+    const unsigned int position = offset + static_cast<unsigned int>(bytes_read);
+
+    zip_lump_t * lump = std::upper_bound(zip->lumps, zip->lumps + zip->numlumps, position, [](unsigned int pos, const zip_lump_t & l) {
+      return pos < l.position;
+    }) - 1;
+
+    const size_t start = position - lump->position;
+    const size_t n     = std::min(buffer_len - bytes_read, static_cast<size_t>(lump->size) - start);
+
+    if (n == 0) {
+      // zero sized lumps share their position with the next one
+      break;
+    }
+
+    if (start == 0 && n == lump->size && lump->size == lump->entry_size) {
+      // a whole entry, straight into the buffer
+      if (!ReadEntry(zip, lump, dest + bytes_read)) {
+        break;
+      }
+    } else {
+      if (zip->cached_entry != static_cast<long>(lump->local)) {
+        // no I_Realloc(), this runs on the prefetch reader thread too
+        auto * cached = static_cast<uint8_t *>(realloc(zip->cached_data, std::max(lump->entry_size, 1u)));
+
+        zip->cached_entry = -1;
+
+        if (cached == nullptr) {
+          break;
+        }
+
+        zip->cached_data = cached;
+
+        if (!ReadEntry(zip, lump, zip->cached_data)) {
+          break;
+        }
+
+        zip->cached_entry = static_cast<long>(lump->local);
+      }
+
+      std::memcpy(dest + bytes_read, zip->cached_data + lump->offset + start, n);
+    }
+
+    bytes_read += n;
+  }
+
+  return bytes_read;
+}
+
+wad_file_class_t zip_wad_file = {
+  W_Zip_OpenFile,
+  W_Zip_CloseFile,
+  W_Zip_Read,
+  nullptr,
+};
+
+#endif /* #ifdef HAVE_LIBZ */
@@ -19,9 +19,13 @@
 //
 
 #include <cctype>
+#include <chrono>
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
 
+#include <fmt/printf.h>
+
 #include "doomtype.hpp"
 #include "i_swap.hpp" // [crispy] LONG()
 #include "i_system.hpp"
@@ -38,9 +42,17 @@ enum section_t
   SECTION_SPRITES,
 };
 
+// Open addressed index of a search list, keyed by W_LumpNameKey()
+struct searchindex_t {
+  uint64_t key;
+  int      index; // -1 for an empty slot
+};
+
 struct searchlist_t {
-  lumpinfo_t ** lumps;
-  int           numlumps;
+  lumpinfo_t **   lumps;
+  int             numlumps;
+  searchindex_t * hash; // built on the first search
+  size_t          hashmask;
 };
 
 struct sprite_frame_t {
@@ -62,23 +74,87 @@ static sprite_frame_t * sprite_frames;
 static int              num_sprite_frames;
 static int              sprite_frames_alloced;
 
+// index of sprite_frames by sprite name and frame
+static int *  sprite_frame_hash;
+static size_t sprite_frame_hashmask;
+
+// Fibonacci hashing, the high bits are the best mixed
+static size_t HashSlot(uint64_t key, size_t mask) {
+  return static_cast<size_t>((key * 0x9e3779b97f4a7c15ULL) >> 32) & mask;
+}
+
+// Smallest power of two of at least twice count, so that the
+// hash tables stay at most half full
+static size_t HashCapacity(int count) {
+  size_t capacity = 16;
+
+  while (capacity < static_cast<size_t>(count) * 2) {
+    capacity *= 2;
+  }
+
+  return capacity;
+}
+
+// Point a search list at a range of lumps, dropping any old index
+
+static void InitList(searchlist_t * list, lumpinfo_t ** lumps, int numlumps_param) {
+  if (list->hash != nullptr) {
+    Z_Free(list->hash);
+    list->hash = nullptr;
+  }
+
+  list->lumps    = lumps;
+  list->numlumps = numlumps_param;
+}
+
+static void HashList(searchlist_t * list) {
+  const size_t capacity = HashCapacity(list->numlumps);
+
+  list->hash     = zmalloc<decltype(list->hash)>(capacity * sizeof(*list->hash), PU_STATIC, nullptr);
+  list->hashmask = capacity - 1;
+
+  for (size_t i = 0; i < capacity; ++i) {
+    list->hash[i].key   = 0;
+    list->hash[i].index = -1;
+  }
+
+  for (int i = 0; i < list->numlumps; ++i) {
+    const uint64_t key  = W_LumpNameKey(list->lumps[i]->name);
+    size_t         slot = HashSlot(key, list->hashmask);
+
+    while (list->hash[slot].index != -1 && list->hash[slot].key != key) {
+      slot = (slot + 1) & list->hashmask;
+    }
+
+    // keep the first lump with each name
+    if (list->hash[slot].index == -1) {
+      list->hash[slot].key   = key;
+      list->hash[slot].index = i;
+    }
+  }
+}
+
 // Search in a list to find a lump with a particular name
-// Linear search (slow!)
 //
 // Returns -1 if not found
 
 static int FindInList(searchlist_t * list, cstring_view name) {
-  for (int i = 0; i < list->numlumps; ++i) {
-    if (!strncasecmp(list->lumps[i]->name, name.c_str(), 8))
-      return i;
+  if (list->hash == nullptr) {
+    HashList(list);
   }
 
-  return -1;
+  const uint64_t key = W_LumpNameKey(name.c_str());
+
+  for (size_t slot = HashSlot(key, list->hashmask);; slot = (slot + 1) & list->hashmask) {
+    if (list->hash[slot].index == -1 || list->hash[slot].key == key) {
+      return list->hash[slot].index;
+    }
+  }
 }
 
 static bool SetupList(searchlist_t * list, searchlist_t * src_list, cstring_view startname, cstring_view endname, cstring_view startname2, cstring_view endname2) {
-  list->numlumps = 0;
-  int startlump  = FindInList(src_list, startname);
+  InitList(list, nullptr, 0);
+  int startlump = FindInList(src_list, startname);
 
   if (startname2.c_str() != nullptr && startlump < 0) {
     startlump = FindInList(src_list, startname2);
@@ -92,8 +168,7 @@ static bool SetupList(searchlist_t * list, searchlist_t * src_list, cstring_view
     }
 
     if (endlump > startlump) {
-      list->lumps    = src_list->lumps + startlump + 1;
-      list->numlumps = endlump - startlump - 1;
+      InitList(list, src_list->lumps + startlump + 1, endlump - startlump - 1);
       return true;
     }
   }
@@ -101,6 +176,23 @@ static bool SetupList(searchlist_t * list, searchlist_t * src_list, cstring_view
   return false;
 }
 
+// Drop the search lists and their indexes once a merge is done
+
+static void FreeLists() {
+  InitList(&iwad, nullptr, 0);
+  InitList(&iwad_sprites, nullptr, 0);
+  InitList(&iwad_flats, nullptr, 0);
+  InitList(&pwad, nullptr, 0);
+  InitList(&pwad_sprites, nullptr, 0);
+  InitList(&pwad_flats, nullptr, 0);
+}
+
+static void PrintMergeTime(std::chrono::steady_clock::time_point start) {
+  const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+  fmt::printf("  merged in %.1f ms\n", elapsed.count());
+}
+
 // Sets up the sprite/flat search lists
 
 static void SetupLists() {
@@ -133,6 +225,46 @@ static void InitSpriteList() {
   }
 
   num_sprite_frames = 0;
+
+  if (sprite_frame_hash != nullptr) {
+    Z_Free(sprite_frame_hash);
+  }
+
+  const size_t capacity = HashCapacity(sprite_frames_alloced);
+
+  sprite_frame_hash     = zmalloc<decltype(sprite_frame_hash)>(capacity * sizeof(*sprite_frame_hash), PU_STATIC, nullptr);
+  sprite_frame_hashmask = capacity - 1;
+
+  for (size_t i = 0; i < capacity; ++i) {
+    sprite_frame_hash[i] = -1;
+  }
+}
+
+// Sprite name (case insensitive) and frame (case sensitive), packed
+
+static uint64_t SpriteFrameKey(const char * name, int frame) {
+  uint64_t key = static_cast<uint8_t>(frame);
+
+  for (int i = 0; i < 4; ++i) {
+    key = (key << 8) | static_cast<uint8_t>(toupper(name[i]));
+  }
+
+  return key;
+}
+
+// Slot for the frame in sprite_frame_hash: either the one holding
+// it, or the empty slot where it goes
+
+static size_t SpriteFrameSlot(const char * name, int frame) {
+  const uint64_t key = SpriteFrameKey(name, frame);
+
+  for (size_t slot = HashSlot(key, sprite_frame_hashmask);; slot = (slot + 1) & sprite_frame_hashmask) {
+    const int index = sprite_frame_hash[slot];
+
+    if (index == -1 || SpriteFrameKey(sprite_frames[index].sprname, sprite_frames[index].frame) == key) {
+      return slot;
+    }
+  }
 }
 
 static bool ValidSpriteLumpName(char * name) {
@@ -161,12 +293,10 @@ static bool ValidSpriteLumpName(char * name) {
 static sprite_frame_t * FindSpriteFrame(char * name, int frame) {
   // Search the list and try to find the frame
 
-  for (int i = 0; i < num_sprite_frames; ++i) {
-    sprite_frame_t * cur = &sprite_frames[i];
+  size_t slot = SpriteFrameSlot(name, frame);
 
-    if (!strncasecmp(cur->sprname, name, 4) && cur->frame == frame) {
-      return cur;
-    }
+  if (sprite_frame_hash[slot] != -1) {
+    return &sprite_frames[sprite_frame_hash[slot]];
   }
 
   // Not found in list; Need to add to the list
@@ -182,6 +312,25 @@ static sprite_frame_t * FindSpriteFrame(char * name, int frame) {
     Z_Free(sprite_frames);
     sprite_frames_alloced *= 2;
     sprite_frames = newframes;
+
+    // Grow the index with it
+
+    Z_Free(sprite_frame_hash);
+
+    const size_t capacity = HashCapacity(sprite_frames_alloced);
+
+    sprite_frame_hash     = zmalloc<decltype(sprite_frame_hash)>(capacity * sizeof(*sprite_frame_hash), PU_STATIC, nullptr);
+    sprite_frame_hashmask = capacity - 1;
+
+    for (size_t i = 0; i < capacity; ++i) {
+      sprite_frame_hash[i] = -1;
+    }
+
+    for (int i = 0; i < num_sprite_frames; ++i) {
+      sprite_frame_hash[SpriteFrameSlot(sprite_frames[i].sprname, sprite_frames[i].frame)] = i;
+    }
+
+    slot = SpriteFrameSlot(name, frame);
   }
 
   // Add to end of list
@@ -193,6 +342,7 @@ static sprite_frame_t * FindSpriteFrame(char * name, int frame) {
   for (auto & angle_lump : result->angle_lumps)
     angle_lump = nullptr;
 
+  sprite_frame_hash[slot] = num_sprite_frames;
   ++num_sprite_frames;
 
   return result;
@@ -471,7 +621,8 @@ static void DoMerge() {
 // Merge in a file by name
 
 void W_MergeFile(cstring_view filename) {
-  int old_numlumps = static_cast<int>(numlumps);
+  const auto start        = std::chrono::steady_clock::now();
+  int        old_numlumps = static_cast<int>(numlumps);
 
   // Load PWAD
 
@@ -480,11 +631,8 @@ void W_MergeFile(cstring_view filename) {
 
   // IWAD is at the start, PWAD was appended to the end
 
-  iwad.lumps    = lumpinfo;
-  iwad.numlumps = old_numlumps;
-
-  pwad.lumps    = lumpinfo + old_numlumps;
-  pwad.numlumps = static_cast<int>(numlumps - static_cast<unsigned int>(old_numlumps));
+  InitList(&iwad, lumpinfo, old_numlumps);
+  InitList(&pwad, lumpinfo + old_numlumps, static_cast<int>(numlumps - static_cast<unsigned int>(old_numlumps)));
 
   // Setup sprite/flat lists
 
@@ -497,6 +645,9 @@ void W_MergeFile(cstring_view filename) {
   // Perform the merge
 
   DoMerge();
+
+  FreeLists();
+  PrintMergeTime(start);
 }
 
 // Replace lumps in the given list with lumps from the PWAD
@@ -517,7 +668,8 @@ static void W_NWTAddLumps(searchlist_t * list) {
 // command-line options.
 
 void W_NWTMergeFile(cstring_view filename, int flags) {
-  int old_numlumps = static_cast<int>(numlumps);
+  const auto start        = std::chrono::steady_clock::now();
+  int        old_numlumps = static_cast<int>(numlumps);
 
   // Load PWAD
 
@@ -526,11 +678,8 @@ void W_NWTMergeFile(cstring_view filename, int flags) {
 
   // IWAD is at the start, PWAD was appended to the end
 
-  iwad.lumps    = lumpinfo;
-  iwad.numlumps = old_numlumps;
-
-  pwad.lumps    = lumpinfo + old_numlumps;
-  pwad.numlumps = static_cast<int>(numlumps - static_cast<unsigned int>(old_numlumps));
+  InitList(&iwad, lumpinfo, old_numlumps);
+  InitList(&pwad, lumpinfo + old_numlumps, static_cast<int>(numlumps - static_cast<unsigned int>(old_numlumps)));
 
   // Setup sprite/flat lists
 
@@ -551,6 +700,9 @@ void W_NWTMergeFile(cstring_view filename, int flags) {
   // Discard the PWAD
 
   numlumps = static_cast<unsigned int>(old_numlumps);
+
+  FreeLists();
+  PrintMergeTime(start);
 }
 
 // Simulates the NWT -merge command line parameter.  What this does is load
@@ -558,7 +710,8 @@ void W_NWTMergeFile(cstring_view filename, int flags) {
 // exist in the PWAD.
 
 void W_NWTDashMerge(cstring_view filename) {
-  int old_numlumps = static_cast<int>(numlumps);
+  const auto start        = std::chrono::steady_clock::now();
+  int        old_numlumps = static_cast<int>(numlumps);
 
   // Load PWAD
 
@@ -570,11 +723,8 @@ void W_NWTDashMerge(cstring_view filename) {
 
   // IWAD is at the start, PWAD was appended to the end
 
-  iwad.lumps    = lumpinfo;
-  iwad.numlumps = old_numlumps;
-
-  pwad.lumps    = lumpinfo + old_numlumps;
-  pwad.numlumps = static_cast<int>(numlumps - static_cast<unsigned int>(old_numlumps));
+  InitList(&iwad, lumpinfo, old_numlumps);
+  InitList(&pwad, lumpinfo + old_numlumps, static_cast<int>(numlumps - static_cast<unsigned int>(old_numlumps)));
 
   // Setup sprite/flat lists
 
@@ -597,6 +747,9 @@ void W_NWTDashMerge(cstring_view filename) {
   numlumps = static_cast<unsigned int>(old_numlumps);
 
   W_CloseFile(wad_file);
+
+  FreeLists();
+  PrintMergeTime(start);
 }
 
 // [crispy] dump merged WAD data into a new IWAD file
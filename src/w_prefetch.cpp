@@ -0,0 +1,257 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Asynchronous lump prefetching for WAD files that are not mapped.
+//
+//	The zone is not thread safe, so the game thread allocates the
+//	buffer for each queued lump as PU_STATIC without an owner. The
+//	reader thread only fills it in with W_ReadBatch(). Once the read is
+//	done, the game thread hands the buffer to lump->cache as
+//	PU_CACHE, as if W_CacheLumpNum() had read it.
+//
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "i_system.hpp"
+#include "w_prefetch.hpp"
+#include "z_zone.hpp"
+
+// Most bytes queued and not yet in the cache; they are PU_STATIC
+// until then, so the zone can't purge them to make room.
+constexpr size_t MAXPREFETCHBYTES = 16 * 1024 * 1024;
+
+struct prefetch_t {
+  lumpinfo_t * lump;
+  void *       buffer;
+  size_t       length; // read so far
+  bool         done;
+};
+
+// queued and not yet in the cache, game thread only
+static std::list<prefetch_t> prefetch_pending;
+static size_t                prefetch_bytes;
+
+// for the reader thread, under prefetch_mutex
+static std::mutex               prefetch_mutex;
+static std::condition_variable  prefetch_queued;
+static std::condition_variable  prefetch_read;
+static std::deque<prefetch_t *> prefetch_queue;
+static bool                     prefetch_stop;
+static std::thread              prefetch_thread;
+
+// Reads the reader thread takes off the queue at once
+constexpr size_t MAXPREFETCHBATCH = 64;
+
+static void ReaderThread() {
+  std::unique_lock<std::mutex> lock(prefetch_mutex);
+
+  std::vector<prefetch_t *> batch;
+  std::vector<wad_read_t>   reads;
+
+  for (;;) {
+    prefetch_queued.wait(lock, [] { return prefetch_stop || !prefetch_queue.empty(); });
+
+    if (prefetch_stop) {
+      return;
+    }
+
+    // Take the queue head, in file order, so that adjacent lumps
+    // are read with one W_ReadBatch() call
+
+    const size_t count = std::min(prefetch_queue.size(), MAXPREFETCHBATCH);
+
+    batch.assign(prefetch_queue.begin(), prefetch_queue.begin() + static_cast<std::ptrdiff_t>(count));
+    prefetch_queue.erase(prefetch_queue.begin(), prefetch_queue.begin() + static_cast<std::ptrdiff_t>(count));
+
+    lock.unlock();
+
+    std::sort(batch.begin(), batch.end(), [](const prefetch_t * a, const prefetch_t * b) {
+      if (a->lump->wad_file != b->lump->wad_file) {
+        return std::less<wad_file_t *>()(a->lump->wad_file, b->lump->wad_file);
+      }
+
+      return a->lump->position < b->lump->position;
+    });
+
+    for (size_t i = 0; i < batch.size();) {
+      wad_file_t * wad_file = batch[i]->lump->wad_file;
+      size_t       end      = i;
+
+      reads.clear();
+      for (; end < batch.size() && batch[end]->lump->wad_file == wad_file; ++end) {
+        reads.push_back({ static_cast<unsigned int>(batch[end]->lump->position), batch[end]->buffer, batch[end]->lump->size, 0 });
+      }
+
+      W_ReadBatch(wad_file, reads.data(), static_cast<int>(reads.size()));
+
+      for (size_t j = i; j < end; ++j) {
+        batch[j]->length = reads[j - i].bytes_read;
+      }
+
+      i = end;
+    }
+
+    lock.lock();
+
+    for (prefetch_t * request : batch) {
+      request->done = true;
+    }
+
+    prefetch_read.notify_all();
+  }
+}
+
+// Called at exit; reads still queued are dropped with the zone.
+// prefetch_mutex must not be held, and an I_Error() on the reader
+// thread itself leaves it to exit with the process.
+
+static void StopReaderThread() {
+  if (std::this_thread::get_id() == prefetch_thread.get_id()) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(prefetch_mutex);
+    prefetch_stop = true;
+  }
+
+  prefetch_queued.notify_one();
+  prefetch_thread.join();
+}
+
+// Called without prefetch_mutex held, as it may I_Error().
+
+static void Install(std::list<prefetch_t>::iterator request) {
+  lumpinfo_t * lump = request->lump;
+
+  if (request->length < lump->size) {
+    I_Error("W_PrefetchLump: only read %i of %i on lump %.8s", static_cast<int>(request->length), static_cast<int>(lump->size), lump->name);
+  }
+
+  Z_ChangeUser(request->buffer, &lump->cache);
+  Z_ChangeTag(request->buffer, PU_CACHE);
+
+  lump->prefetched = false;
+  prefetch_bytes -= lump->size;
+  prefetch_pending.erase(request);
+}
+
+void W_PrefetchLump(lumpindex_t lumpnum) {
+  if (static_cast<unsigned>(lumpnum) >= numlumps) {
+    I_Error("W_PrefetchLump: %i >= numlumps", lumpnum);
+  }
+
+  lumpinfo_t * lump = lumpinfo[lumpnum];
+
+  // Mapped files are read with a memcpy, nothing to gain
+
+  if (lump->cache != nullptr || lump->prefetched || lump->size == 0
+      || lump->wad_file->mapped != nullptr) {
+    return;
+  }
+
+  if (prefetch_bytes + lump->size > MAXPREFETCHBYTES) {
+    W_PrefetchPoll();
+
+    if (prefetch_bytes + lump->size > MAXPREFETCHBYTES) {
+      return;
+    }
+  }
+
+  if (!prefetch_thread.joinable()) {
+    prefetch_thread = std::thread(ReaderThread);
+    I_AtExit(StopReaderThread, true);
+  }
+
+  prefetch_t & request = prefetch_pending.emplace_back();
+  request.lump         = lump;
+  request.buffer       = Z_Malloc(static_cast<int>(lump->size), PU_STATIC, nullptr);
+  request.length       = 0;
+  request.done         = false;
+
+  lump->prefetched = true;
+  prefetch_bytes += lump->size;
+
+  {
+    std::lock_guard<std::mutex> lock(prefetch_mutex);
+    prefetch_queue.push_back(&request);
+  }
+
+  prefetch_queued.notify_one();
+}
+
+void W_PrefetchPoll() {
+  std::vector<std::list<prefetch_t>::iterator> done;
+
+  {
+    std::lock_guard<std::mutex> lock(prefetch_mutex);
+
+    for (auto request = prefetch_pending.begin(); request != prefetch_pending.end(); ++request) {
+      if (request->done) {
+        done.push_back(request);
+      }
+    }
+  }
+
+  for (auto request : done) {
+    Install(request);
+  }
+}
+
+void W_PrefetchWait(lumpinfo_t * lump) {
+  auto request = std::find_if(prefetch_pending.begin(), prefetch_pending.end(), [lump](const prefetch_t & r) { return r.lump == lump; });
+
+  if (request == prefetch_pending.end()) {
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(prefetch_mutex);
+
+  // If the reader hasn't got to it yet, don't wait for everything
+  // queued in front of it: take it back and read it here.
+
+  auto queued = std::find(prefetch_queue.begin(), prefetch_queue.end(), &*request);
+
+  if (queued != prefetch_queue.end()) {
+    prefetch_queue.erase(queued);
+    lock.unlock();
+
+    request->length = W_Read(lump->wad_file, static_cast<unsigned int>(lump->position), request->buffer, lump->size);
+    request->done   = true;
+  } else {
+    prefetch_read.wait(lock, [&request] { return request->done; });
+    lock.unlock();
+  }
+
+  Install(request);
+}
+
+void W_PrefetchFlush() {
+  {
+    std::unique_lock<std::mutex> lock(prefetch_mutex);
+
+    prefetch_read.wait(lock, [] {
+      return std::all_of(prefetch_pending.begin(), prefetch_pending.end(), [](const prefetch_t & r) { return r.done; });
+    });
+  }
+
+  W_PrefetchPoll();
+}
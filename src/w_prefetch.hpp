@@ -0,0 +1,34 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Asynchronous lump prefetching for WAD files that are not mapped.
+//
+
+#pragma once
+
+#include "w_wad.hpp"
+
+// Queue a read of the lump on the background reader thread, if it is
+// not cached yet and its file is not memory mapped. A later
+// W_CacheLumpNum() picks up the data, waiting for it if needed.
+void W_PrefetchLump(lumpindex_t lump);
+
+// Move finished reads into the lump cache as PU_CACHE.
+void W_PrefetchPoll();
+
+// Wait for the queued read of the lump and move it into the cache.
+void W_PrefetchWait(lumpinfo_t * lump);
+
+// Wait for all queued reads, before WAD files change.
+void W_PrefetchFlush();
@@ -17,9 +17,11 @@
 //
 
 #include <cctype>
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <string>
+#include <vector>
 
 #include <fmt/printf.h>
 
@@ -29,7 +31,9 @@
 #include "i_swap.hpp"
 #include "i_system.hpp"
 #include "m_misc.hpp"
+#include "m_profile.hpp"
 #include "v_diskicon.hpp"
+#include "w_prefetch.hpp"
 #include "z_zone.hpp"
 
 #include "memory.hpp"
@@ -58,8 +62,16 @@ typedef PACKED_STRUCT(
 lumpinfo_t ** lumpinfo;
 size_t        numlumps = 0;
 
-// Hash table for fast lookups
-static lumpindex_t * lumphash;
+// Hash table for fast lookups, open addressed and keyed by the packed
+// lump name. Each slot holds the newest lump with that name; older lumps
+// with the same name are chained through lumpinfo[i]->next.
+struct lumphash_entry_t {
+  uint64_t    key;
+  lumpindex_t lump; // -1 for an empty slot
+};
+
+static lumphash_entry_t * lumphash;
+static size_t             lumphash_mask;
 
 // Variables for the reload hack: filename of the PWAD to reload, and the
 // lumps from WADs before the reload file, so we can resent numlumps and
@@ -84,6 +96,34 @@ unsigned int W_LumpNameHash(cstring_view name) {
   return result;
 }
 
+// Pack a lump name into a 64-bit key, upper case and zero padded,
+// so that two names match exactly when strncasecmp(a, b, 8) would.
+uint64_t W_LumpNameKey(const char * name) {
+  uint64_t key = 0;
+
+  for (unsigned int i = 0; i < 8 && name[i] != '\0'; ++i) {
+    key |= static_cast<uint64_t>(static_cast<uint8_t>(toupper(name[i]))) << (i * 8);
+  }
+
+  return key;
+}
+
+static size_t W_LumpKeySlot(uint64_t key) {
+  // Fibonacci hashing, the high bits are the best mixed
+  return static_cast<size_t>((key * 0x9e3779b97f4a7c15ULL) >> 32) & lumphash_mask;
+}
+
+// Slot holding key, or the empty slot where it would go.
+static lumphash_entry_t * W_LumpHashSlot(uint64_t key) {
+  for (size_t slot = W_LumpKeySlot(key);; slot = (slot + 1) & lumphash_mask) {
+    lumphash_entry_t * entry = &lumphash[slot];
+
+    if (entry->lump == -1 || entry->key == key) {
+      return entry;
+    }
+  }
+}
+
 //
 // LUMP BASED ROUTINES.
 //
@@ -94,6 +134,7 @@ unsigned int W_LumpNameHash(cstring_view name) {
 //  found (PWAD, if all required lumps are present).
 // Files with a .wad extension are wadlink files
 //  with multiple lumps.
+// [crispy] So are .pk3 and .zip archives, see w_file_zip.cpp.
 // Other files are single lumps with the base filename
 //  for the lump name.
 
@@ -127,7 +168,9 @@ wad_file_t * W_AddFile(cstring_view name) {
   filelump_t * fileinfo     = nullptr;
   int          numfilelumps = 0;
 
-  if (!iequals(filename + strlen(filename) - 3, "wad")) {
+  const char * extension = filename + strlen(filename) - 3;
+
+  if (!iequals(extension, "wad") && !iequals(extension, "pk3") && !iequals(extension, "zip")) {
     // single lump file
 
     // fraggle: Swap the filepos and size here.  The WAD directory
@@ -200,6 +243,7 @@ wad_file_t * W_AddFile(cstring_view name) {
     lump_p->position    = LONG(filerover->filepos);
     lump_p->size        = LONG(filerover->size);
     lump_p->cache       = nullptr;
+    lump_p->prefetched  = false;
     strncpy(lump_p->name, filerover->name, 8);
     lumpinfo[i] = lump_p;
 
@@ -241,22 +285,16 @@ lumpindex_t W_CheckNumForName(cstring_view name) {
   if (lumphash != nullptr) {
     // We do! Excellent.
 
-    int hash = static_cast<int>(W_LumpNameHash(name) % numlumps);
+    return W_LumpHashSlot(W_LumpNameKey(name.c_str()))->lump;
+  }
 
-    for (lumpindex_t i = lumphash[hash]; i != -1; i = lumpinfo[i]->next) {
-      if (!strncasecmp(lumpinfo[i]->name, name.c_str(), 8)) {
-        return i;
-      }
-    }
-  } else {
-    // We don't have a hash table generate yet. Linear search :-(
-    //
-    // scan backwards so patch lump files take precedence
+  // We don't have a hash table generate yet. Linear search :-(
+  //
+  // scan backwards so patch lump files take precedence
 
-    for (auto i = static_cast<lumpindex_t>(numlumps - 1); i >= 0; --i) {
-      if (!strncasecmp(lumpinfo[i]->name, name.c_str(), 8)) {
-        return i;
-      }
+  for (auto i = static_cast<lumpindex_t>(numlumps - 1); i >= 0; --i) {
+    if (!strncasecmp(lumpinfo[i]->name, name.c_str(), 8)) {
+      return i;
     }
   }
 
@@ -279,7 +317,20 @@ lumpindex_t W_GetNumForName(cstring_view name) {
   return i;
 }
 
+// Search backwards for the newest lump named name in [to, from], such as
+// between the markers of a namespace.
 lumpindex_t W_CheckNumForNameFromTo(cstring_view name, int from, int to) {
+  if (lumphash != nullptr) {
+    // walk down the lumps sharing this name, newest first
+    lumpindex_t i = W_LumpHashSlot(W_LumpNameKey(name.c_str()))->lump;
+
+    while (i > from) {
+      i = lumpinfo[i]->next;
+    }
+
+    return i >= to ? i : -1;
+  }
+
   for (lumpindex_t i = from; i >= to; i--) {
     if (!strncasecmp(lumpinfo[i]->name, name.c_str(), 8)) {
       return i;
@@ -338,6 +389,8 @@ void W_ReadLump(lumpindex_t lump, void * dest) {
 //
 
 [[nodiscard]] void * W_CacheLumpNum(lumpindex_t lumpnum, int tag) {
+  PROFILE_ZONE("W_CacheLumpNum");
+
   void * result = nullptr;
 
   if (static_cast<unsigned>(lumpnum) >= numlumps) {
@@ -346,16 +399,18 @@ void W_ReadLump(lumpindex_t lump, void * dest) {
 
   lumpinfo_t * lump = lumpinfo[lumpnum];
 
-  // Get the pointer to return.  If the lump is in a memory-mapped
-  // file, we can just return a pointer to within the memory-mapped
-  // region.  If the lump is in an ordinary file, we may already
-  // have it cached; otherwise, load it into memory.
+  // [crispy] collect a queued read of the lump
+  if (lump->prefetched) {
+    W_PrefetchWait(lump);
+  }
 
-  if (lump->wad_file->mapped != nullptr) {
-    // Memory mapped file, return from the mmapped region.
+  // Get the pointer to return.  If the lump is already cached,
+  // just switch the zone tag; otherwise, load it into memory.
+  // [crispy] Lumps are copied out of memory-mapped files too, as
+  // callers may write to the buffer but the mapping is read-only.
+  // Use W_LumpView() to read a lump without a copy.
 
-    result = lump->wad_file->mapped + lump->position;
-  } else if (lump->cache != nullptr) {
+  if (lump->cache != nullptr) {
     // Already cached, so just switch the zone tag.
 
     result = lump->cache;
@@ -371,6 +426,79 @@ void W_ReadLump(lumpindex_t lump, void * dest) {
   return result;
 }
 
+//
+// [crispy] W_CacheLumpRange
+//
+// Cache the count lumps from first on, like W_CacheLumpNum() would,
+// but read the ones that are not cached yet with W_ReadBatch(). Lumps
+// that follow each other in a WAD file, such as the lumps of a map,
+// then take one read call together.
+//
+
+void W_CacheLumpRange(lumpindex_t first, int count, int tag) {
+  if (first < 0 || count < 0 || static_cast<size_t>(first) + static_cast<size_t>(count) > numlumps) {
+    I_Error("W_CacheLumpRange: %i + %i > numlumps", first, count);
+  }
+
+  std::vector<wad_read_t>  reads;
+  std::vector<lumpindex_t> lumps;
+  wad_file_t *             batch_file = nullptr;
+
+  auto read_batch = [&]() {
+    if (reads.empty()) {
+      return;
+    }
+
+    W_ReadBatch(batch_file, reads.data(), static_cast<int>(reads.size()));
+
+    for (size_t i = 0; i < reads.size(); ++i) {
+      lumpinfo_t * lump = lumpinfo[lumps[i]];
+
+      if (reads[i].bytes_read < lump->size) {
+        I_Error("W_CacheLumpRange: only read %i of %i on lump %i",
+                static_cast<int>(reads[i].bytes_read),
+                static_cast<int>(lump->size),
+                lumps[i]);
+      }
+
+      // read in as PU_STATIC, so that none of the batch is purged
+      // while the rest of it is allocated
+      Z_ChangeTag(lump->cache, tag);
+    }
+
+    reads.clear();
+    lumps.clear();
+  };
+
+  for (lumpindex_t lumpnum = first; lumpnum < first + count; ++lumpnum) {
+    lumpinfo_t * lump = lumpinfo[lumpnum];
+
+    if (lump->prefetched) {
+      W_PrefetchWait(lump);
+    }
+
+    if (lump->cache != nullptr) {
+      Z_ChangeTag(lump->cache, tag);
+      continue;
+    }
+
+    // batches are per file and in file order
+    if (lump->wad_file != batch_file
+        || (!reads.empty() && static_cast<unsigned int>(lump->position) < reads.back().offset)) {
+      read_batch();
+      batch_file = lump->wad_file;
+    }
+
+    V_BeginRead(lump->size);
+
+    lump->cache = zmalloc<decltype(lump->cache)>(lump->size, PU_STATIC, &lump->cache);
+    reads.push_back({ static_cast<unsigned int>(lump->position), lump->cache, lump->size, 0 });
+    lumps.push_back(lumpnum);
+  }
+
+  read_batch();
+}
+
 //
 // W_CacheLumpName
 //
@@ -378,6 +506,34 @@ void W_ReadLump(lumpindex_t lump, void * dest) {
   return W_CacheLumpNum(W_GetNumForName(name), tag);
 }
 
+//
+// [crispy] W_LumpView
+//
+// Return a read-only view of a lump. For a memory-mapped file this
+// points straight into the mapping, so nothing is read or copied.
+// Otherwise the lump is cached with the given tag, just as
+// W_CacheLumpNum() would, and the view lives as long as that cache.
+// Views taken with PU_STATIC are released with W_ReleaseLumpView().
+//
+
+lump_view_t W_LumpView(lumpindex_t lumpnum, int tag) {
+  if (static_cast<unsigned>(lumpnum) >= numlumps) {
+    I_Error("W_LumpView: %i >= numlumps", lumpnum);
+  }
+
+  lumpinfo_t * lump = lumpinfo[lumpnum];
+
+  if (lump->wad_file->mapped != nullptr) {
+    return { lump->wad_file->mapped + lump->position, lump->size };
+  }
+
+  return { static_cast<const uint8_t *>(W_CacheLumpNum(lumpnum, tag)), lump->size };
+}
+
+lump_view_t W_LumpViewName(cstring_view name, int tag) {
+  return W_LumpView(W_GetNumForName(name), tag);
+}
+
 //
 // Release a lump back to the cache, so that it can be reused later
 // without having to read from disk again, or alternatively, discarded
@@ -395,17 +551,25 @@ void W_ReleaseLumpNum(lumpindex_t lumpnum) {
 
   lumpinfo_t * lump = lumpinfo[lumpnum];
 
-  if (lump->wad_file->mapped != nullptr) {
-    // Memory-mapped file, so nothing needs to be done here.
-  } else {
-    Z_ChangeTag(lump->cache, PU_CACHE);
-  }
+  Z_ChangeTag(lump->cache, PU_CACHE);
 }
 
 void W_ReleaseLumpName(cstring_view name) {
   W_ReleaseLumpNum(W_GetNumForName(name));
 }
 
+// [crispy] a view into a mapped file has no cache to release
+
+void W_ReleaseLumpView(lumpindex_t lumpnum) {
+  if (static_cast<unsigned>(lumpnum) >= numlumps) {
+    I_Error("W_ReleaseLumpView: %i >= numlumps", lumpnum);
+  }
+
+  if (lumpinfo[lumpnum]->wad_file->mapped == nullptr) {
+    W_ReleaseLumpNum(lumpnum);
+  }
+}
+
 #if 0
 
 //
@@ -477,23 +641,34 @@ void W_GenerateHashTable() {
   // Free the old hash table, if there is one:
   if (lumphash != nullptr) {
     Z_Free(lumphash);
+    lumphash = nullptr;
   }
 
   // Generate hash table
   if (numlumps > 0) {
-    lumphash = zmalloc<decltype(lumphash)>(sizeof(lumpindex_t) * numlumps, PU_STATIC, nullptr);
+    // at most half full, so probe sequences stay short
+    size_t capacity = 16;
+    while (capacity < numlumps * 2) {
+      capacity *= 2;
+    }
 
-    for (unsigned int i = 0; i < numlumps; ++i) {
-      lumphash[i] = -1;
+    lumphash      = zmalloc<decltype(lumphash)>(sizeof(*lumphash) * capacity, PU_STATIC, nullptr);
+    lumphash_mask = capacity - 1;
+
+    for (size_t i = 0; i < capacity; ++i) {
+      lumphash[i].key  = 0;
+      lumphash[i].lump = -1;
     }
 
     for (unsigned int i = 0; i < numlumps; ++i) {
-      auto hash = static_cast<unsigned int>(W_LumpNameHash(lumpinfo[i]->name) % numlumps);
+      uint64_t           key   = W_LumpNameKey(lumpinfo[i]->name);
+      lumphash_entry_t * entry = W_LumpHashSlot(key);
 
-      // Hook into the hash table
+      // Hook into the hash table, later lumps take precedence
 
-      lumpinfo[i]->next = lumphash[hash];
-      lumphash[hash]    = static_cast<lumpindex_t>(i);
+      lumpinfo[i]->next = entry->lump;
+      entry->key        = key;
+      entry->lump       = static_cast<lumpindex_t>(i);
     }
   }
 
@@ -511,6 +686,9 @@ void W_Reload() {
     return;
   }
 
+  // [crispy] Let queued reads finish before the file goes away
+  W_PrefetchFlush();
+
   // We must free any lumps being cached from the PWAD we're about to reload:
   for (auto i = static_cast<unsigned int>(reloadlump); i < numlumps; ++i) {
     if (lumpinfo[i]->cache != nullptr) {
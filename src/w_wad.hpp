@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <cstdio>
 
 #include "doomtype.hpp"
@@ -41,10 +42,21 @@ struct lumpinfo_s {
   size_t       size;
   void *       cache;
 
-  // Used for hash table lookups
+  // [crispy] a read of the lump is queued in w_prefetch.cpp
+  bool prefetched;
+
+  // Used for hash table lookups: the previous lump with the same
+  // name, or -1
   lumpindex_t next;
 };
 
+// [crispy] Read-only view of a lump's data, which must not be written to.
+// It points into the WAD file's mapping, or else into the lump's cache.
+struct lump_view_t {
+  const uint8_t * data;
+  size_t          size;
+};
+
 extern lumpinfo_t ** lumpinfo;
 extern size_t        numlumps;
 
@@ -60,13 +72,19 @@ void   W_ReadLump(lumpindex_t lump, void * dest);
 
 void * W_CacheLumpNum(lumpindex_t lump, int tag);
 void * W_CacheLumpName(cstring_view name, int tag);
+void   W_CacheLumpRange(lumpindex_t first, int count, int tag);
+
+lump_view_t W_LumpView(lumpindex_t lump, int tag);
+lump_view_t W_LumpViewName(cstring_view name, int tag);
 
 void W_GenerateHashTable();
 
 extern unsigned int W_LumpNameHash(cstring_view s);
+uint64_t            W_LumpNameKey(const char * name);
 
 void W_ReleaseLumpNum(lumpindex_t lump);
 void W_ReleaseLumpName(cstring_view name);
+void W_ReleaseLumpView(lumpindex_t lump);
 
 const char * W_WadNameForLump(const lumpinfo_t * lump);
 bool         W_IsIWADLump(const lumpinfo_t * lump);
@@ -45,6 +45,9 @@ struct memblock_s {
 
 static memblock_t * allocated_blocks[PU_NUM_TAGS];
 
+// [crispy] for Z_GetStats()
+static int zone_purges;
+
 #ifdef TESTING
 
 static int test_malloced = 0;
@@ -190,6 +193,7 @@ static bool ClearCache(int size) {
     }
 
     free(block);
+    zone_purges++;
 
     block = next_block;
   }
@@ -426,3 +430,19 @@ void Z_ChangeTag2(void * ptr, int tag, cstring_view file, int line) {
 [[maybe_unused]] unsigned int Z_ZoneSize() {
   return 0;
 }
+
+//
+// Z_GetStats
+// [crispy] There is no zone, so only the allocated blocks are counted.
+//
+void Z_GetStats(zone_stats_t * stats) {
+  *stats        = {};
+  stats->purges = zone_purges;
+
+  for (int tag = 0; tag < PU_NUM_TAGS; ++tag) {
+    for (memblock_t * block = allocated_blocks[tag]; block != nullptr; block = block->next) {
+      stats->tag_bytes[tag] += sizeof(memblock_t) + static_cast<size_t>(block->size);
+      stats->tag_blocks[tag]++;
+    }
+  }
+}
@@ -0,0 +1,633 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Zone Memory Allocation, segregated fit.
+//
+//	This is an implementation of the zone memory API on the same
+//	zone heap as z_zone.cpp, with the block lookups made cheap:
+//
+//	 - Free blocks are kept in one list per power of two size
+//	   class, with a bitmap of the classes that are not empty.
+//	 - Allocated blocks are kept in one chain per tag, so that
+//	   Z_FreeTags() only visits the blocks it frees.
+//	 - The chains of the purgable tags are in least recently used
+//	   order. Z_Malloc() purges from their tails when no free block
+//	   fits, and Z_ChangeTag() moves a block back to the head.
+//
+
+#include <bit>
+#include <cstring>
+
+#include <fmt/printf.h>
+
+#include "doomtype.hpp"
+#include "i_system.hpp"
+#include "m_argv.hpp"
+
+#include "z_zone.hpp"
+
+constexpr auto MEM_ALIGN = sizeof(void *);
+constexpr auto ZONEID    = 0x1d4a11;
+constexpr auto ZONECAP   = 0x1d4a12; // id of the zone end caps
+
+struct memblock_t {
+  int          size; // including the header
+  int          tag;  // PU_FREE if this is free
+  int          id;   // should be ZONEID, 0 if free
+  void **      user;
+  memblock_t * prev; // physically previous block, nullptr for the first
+  memblock_t * list_prev; // size class list if free, tag chain otherwise
+  memblock_t * list_next;
+};
+
+// Free block lists by size class, class n holds sizes [2^n, 2^(n+1))
+
+constexpr int NUMSIZECLASSES = 32;
+
+static memblock_t free_lists[NUMSIZECLASSES];
+static uint32_t   free_classes; // bit n set if free_lists[n] is not empty
+
+// Allocated block chains by tag, most recently used first
+
+static memblock_t tag_chains[PU_NUM_TAGS];
+
+// Every zone starts and ends with a header-only PU_STATIC block with
+// id ZONECAP, so that merging free blocks never runs off either end
+// of a zone.
+
+struct memzone_t {
+  int         size; // total bytes malloced, including this header
+  memzone_t * next;
+};
+
+static memzone_t * zones;
+static bool        zero_on_free;
+static bool        scan_on_free;
+
+// [crispy] for Z_GetStats()
+static int zone_purges;
+static int zone_grows;
+
+static void ListInit(memblock_t * list) {
+  list->list_next = list->list_prev = list;
+}
+
+static void ListInsert(memblock_t * list, memblock_t * block) {
+  block->list_prev            = list;
+  block->list_next            = list->list_next;
+  block->list_next->list_prev = block;
+  list->list_next             = block;
+}
+
+static void ListRemove(memblock_t * block) {
+  block->list_prev->list_next = block->list_next;
+  block->list_next->list_prev = block->list_prev;
+}
+
+static memblock_t * NextBlock(memblock_t * block) {
+  return reinterpret_cast<memblock_t *>(reinterpret_cast<uint8_t *>(block) + block->size);
+}
+
+static void * BlockData(memblock_t * block) {
+  return reinterpret_cast<uint8_t *>(block) + sizeof(memblock_t);
+}
+
+static memblock_t * DataBlock(void * ptr) {
+  return reinterpret_cast<memblock_t *>(reinterpret_cast<uint8_t *>(ptr) - sizeof(memblock_t));
+}
+
+static int SizeClass(int size) {
+  return std::bit_width(static_cast<unsigned int>(size)) - 1;
+}
+
+static void InsertFree(memblock_t * block) {
+  int sizeclass = SizeClass(block->size);
+
+  block->tag  = PU_FREE;
+  block->user = nullptr;
+  block->id   = 0;
+
+  ListInsert(&free_lists[sizeclass], block);
+  free_classes |= 1u << sizeclass;
+}
+
+static void RemoveFree(memblock_t * block) {
+  int sizeclass = SizeClass(block->size);
+
+  ListRemove(block);
+
+  if (free_lists[sizeclass].list_next == &free_lists[sizeclass]) {
+    free_classes &= ~(1u << sizeclass);
+  }
+}
+
+static memblock_t * FirstBlock(memzone_t * zone) {
+  return reinterpret_cast<memblock_t *>(reinterpret_cast<uint8_t *>(zone) + ((sizeof(memzone_t) + MEM_ALIGN - 1) & ~(MEM_ALIGN - 1)));
+}
+
+//
+// AddZone
+// Get another zone heap from the system and make it one free block.
+//
+static void AddZone() {
+  int    size = 0;
+  auto * zone = reinterpret_cast<memzone_t *>(I_ZoneBase(&size));
+
+  zone->size = size;
+  zone->next = zones;
+  zones      = zone;
+
+  memblock_t * first = FirstBlock(zone);
+  auto *       last  = reinterpret_cast<memblock_t *>((reinterpret_cast<uintptr_t>(zone) + static_cast<unsigned int>(size) - sizeof(memblock_t)) & ~(MEM_ALIGN - 1));
+
+  // the end caps are allocated but in no tag chain
+  first->size = static_cast<int>(sizeof(memblock_t));
+  first->tag  = PU_STATIC;
+  first->id   = ZONECAP;
+  first->user = nullptr;
+  first->prev = nullptr;
+
+  auto * block = NextBlock(first);
+  block->size  = static_cast<int>(reinterpret_cast<uint8_t *>(last) - reinterpret_cast<uint8_t *>(block));
+  block->prev  = first;
+  InsertFree(block);
+
+  last->size = static_cast<int>(sizeof(memblock_t));
+  last->tag  = PU_STATIC;
+  last->id   = ZONECAP;
+  last->user = nullptr;
+  last->prev = block;
+}
+
+//
+// Z_Init
+//
+void Z_Init() {
+  for (auto & list : free_lists) {
+    ListInit(&list);
+  }
+  for (auto & chain : tag_chains) {
+    ListInit(&chain);
+  }
+
+  free_classes = 0;
+  zones        = nullptr;
+
+  AddZone();
+
+  // [Deliberately undocumented]
+  // Zone memory debugging flag. If set, memory is zeroed after it is freed
+  // to deliberately break any code that attempts to use it after free.
+  //
+  zero_on_free = M_ParmExists("-zonezero");
+
+  // [Deliberately undocumented]
+  // Zone memory debugging flag. If set, each time memory is freed, the zone
+  // heap is scanned to look for remaining pointers to the freed block.
+  //
+  scan_on_free = M_ParmExists("-zonescan");
+}
+
+// Scan the zone heap for pointers within the specified range, and warn about
+// any remaining pointers.
+static void ScanForBlock(void * start, void * end) {
+  for (int tag : { PU_STATIC, PU_LEVEL, PU_LEVSPEC }) {
+    for (memblock_t * block = tag_chains[tag].list_next; block != &tag_chains[tag]; block = block->list_next) {
+      // Scan for pointers on the assumption that pointers are aligned
+      // on word boundaries (word size depending on pointer size):
+      auto ** mem = static_cast<void **>(BlockData(block));
+      int     len = static_cast<int>((static_cast<unsigned long>(block->size) - sizeof(memblock_t)) / sizeof(void *));
+
+      for (int i = 0; i < len; ++i) {
+        if (start <= mem[i] && mem[i] <= end) {
+          fmt::fprintf(stderr,
+                       "%p has dangling pointer into freed block "
+                       "%p (%p -> %p)\n",
+                       reinterpret_cast<void *>(mem),
+                       start,
+                       reinterpret_cast<void *>(&mem[i]),
+                       reinterpret_cast<void *>(mem[i]));
+        }
+      }
+    }
+  }
+}
+
+//
+// FreeBlock
+// Free an allocated block and merge it with its free neighbours.
+// Returns the merged free block.
+//
+static memblock_t * FreeBlock(memblock_t * block) {
+  if (block->user != nullptr) {
+    // clear the user's mark
+    *block->user = nullptr;
+  }
+
+  ListRemove(block);
+
+  // If the -zonezero flag is provided, we zero out the block on free
+  // to break code that depends on reading freed memory.
+  if (zero_on_free) {
+    std::memset(BlockData(block), 0, static_cast<unsigned long>(block->size) - sizeof(memblock_t));
+  }
+  if (scan_on_free) {
+    ScanForBlock(BlockData(block),
+                 reinterpret_cast<uint8_t *>(block) + block->size);
+  }
+
+  memblock_t * other = block->prev;
+
+  if (other->tag == PU_FREE) {
+    // merge with previous free block
+    RemoveFree(other);
+    other->size += block->size;
+    block = other;
+  }
+
+  other = NextBlock(block);
+
+  if (other->tag == PU_FREE) {
+    // merge the next free block onto the end
+    RemoveFree(other);
+    block->size += other->size;
+  }
+
+  NextBlock(block)->prev = block;
+  InsertFree(block);
+
+  return block;
+}
+
+//
+// Z_Free
+//
+void Z_Free(void * ptr) {
+  memblock_t * block = DataBlock(ptr);
+
+  if (block->id != ZONEID)
+    I_Error("Z_Free: freed a pointer without ZONEID");
+
+  FreeBlock(block);
+}
+
+//
+// FindFreeBlock
+// The first free block of at least size bytes in the smallest size
+// class that has one, or nullptr.
+//
+static memblock_t * FindFreeBlock(int size) {
+  int sizeclass = SizeClass(size);
+
+  // the own size class holds smaller blocks too
+  if (free_classes & (1u << sizeclass)) {
+    for (memblock_t * block = free_lists[sizeclass].list_next; block != &free_lists[sizeclass]; block = block->list_next) {
+      if (block->size >= size) {
+        return block;
+      }
+    }
+  }
+
+  // every block of a larger class fits
+  uint32_t larger = sizeclass + 1 < NUMSIZECLASSES ? free_classes & (~0u << (sizeclass + 1)) : 0;
+
+  if (larger == 0) {
+    return nullptr;
+  }
+
+  sizeclass = std::countr_zero(larger);
+
+  return free_lists[sizeclass].list_next;
+}
+
+//
+// PurgeBlock
+// Free the least recently used purgable block.
+// Returns the merged free block, or nullptr if nothing is purgable.
+//
+static memblock_t * PurgeBlock() {
+  for (int tag : { PU_CACHE, PU_PURGELEVEL }) {
+    if (tag_chains[tag].list_prev != &tag_chains[tag]) {
+      zone_purges++;
+      return FreeBlock(tag_chains[tag].list_prev);
+    }
+  }
+
+  return nullptr;
+}
+
+//
+// Z_Malloc
+// You can pass a nullptr user if the tag is < PU_PURGELEVEL.
+//
+constexpr auto MINFRAGMENT = 64;
+
+void *
+    Z_Malloc(int    size,
+             int    tag,
+             void * user) {
+  if (tag < 0 || tag >= PU_NUM_TAGS || tag == PU_FREE) {
+    I_Error("Z_Malloc: attempted to allocate a block with an invalid "
+            "tag: %i",
+            tag);
+  }
+
+  if (user == nullptr && tag >= PU_PURGELEVEL)
+    I_Error("Z_Malloc: an owner is required for purgable blocks");
+
+  size = static_cast<int>((static_cast<unsigned long>(size) + MEM_ALIGN - 1) & ~(MEM_ALIGN - 1));
+
+  // account for size of block header
+  size = size + static_cast<int>(sizeof(memblock_t));
+
+  memblock_t * base = FindFreeBlock(size);
+
+  // throw out purgable blocks, oldest first,
+  // until one merges into a block big enough
+  while (base == nullptr) {
+    memblock_t * merged = PurgeBlock();
+
+    if (merged == nullptr) {
+      // [crispy] allocate another zone twice as big
+      AddZone();
+      zone_grows++;
+      base = FindFreeBlock(size);
+    } else if (merged->size >= size) {
+      base = merged;
+    }
+  }
+
+  RemoveFree(base);
+
+  // found a block big enough
+  int extra = base->size - size;
+
+  if (extra > MINFRAGMENT) {
+    // there will be a free fragment after the allocated block
+    auto * newblock = reinterpret_cast<memblock_t *>(reinterpret_cast<uint8_t *>(base) + size);
+    newblock->size  = extra;
+    newblock->prev  = base;
+
+    NextBlock(newblock)->prev = newblock;
+    InsertFree(newblock);
+
+    base->size = size;
+  }
+
+  base->user = static_cast<void **>(user);
+  base->tag  = tag;
+  base->id   = ZONEID;
+
+  ListInsert(&tag_chains[tag], base);
+
+  void * result = BlockData(base);
+
+  if (base->user) {
+    *base->user = result;
+  }
+
+  return result;
+}
+
+//
+// Z_FreeTags
+//
+void Z_FreeTags(int lowtag,
+                int hightag) {
+  for (int tag = lowtag; tag <= hightag; ++tag) {
+    if (tag == PU_FREE) {
+      continue;
+    }
+
+    // free blocks go to the size class lists,
+    // so this only visits the blocks freed
+    while (tag_chains[tag].list_next != &tag_chains[tag]) {
+      FreeBlock(tag_chains[tag].list_next);
+    }
+  }
+}
+
+//
+// Z_DumpHeap
+// Note: TFileDumpHeap( stdout ) ?
+//
+[[maybe_unused]] void Z_DumpHeap(int lowtag,
+                                 int hightag) {
+  for (memzone_t * zone = zones; zone != nullptr; zone = zone->next) {
+    fmt::printf("zone size: %i  location: %p\n",
+                zone->size,
+                reinterpret_cast<void *>(zone));
+
+    fmt::printf("tag range: %i to %i\n",
+                lowtag,
+                hightag);
+
+    for (memblock_t * block = NextBlock(FirstBlock(zone));; block = NextBlock(block)) {
+      if (block->id == ZONECAP) {
+        // the end cap, all blocks have been hit
+        break;
+      }
+
+      if (block->tag >= lowtag && block->tag <= hightag)
+        fmt::printf("block:%p    size:%7i    user:%p    tag:%3i\n",
+                    reinterpret_cast<void *>(block),
+                    block->size,
+                    reinterpret_cast<void *>(block->user),
+                    block->tag);
+
+      if (NextBlock(block)->prev != block)
+        fmt::printf("ERROR: next block doesn't have proper back link\n");
+
+      if (block->tag == PU_FREE && NextBlock(block)->tag == PU_FREE)
+        fmt::printf("ERROR: two consecutive free blocks\n");
+    }
+  }
+}
+
+//
+// Z_FileDumpHeap
+//
+[[maybe_unused]] void Z_FileDumpHeap(FILE * f) {
+  for (memzone_t * zone = zones; zone != nullptr; zone = zone->next) {
+    fmt::fprintf(f, "zone size: %i  location: %p\n", zone->size, reinterpret_cast<void *>(zone));
+
+    for (memblock_t * block = NextBlock(FirstBlock(zone));; block = NextBlock(block)) {
+      if (block->id == ZONECAP) {
+        // the end cap, all blocks have been hit
+        break;
+      }
+
+      fmt::fprintf(f, "block:%p    size:%7i    user:%p    tag:%3i\n", reinterpret_cast<void *>(block), block->size, reinterpret_cast<void *>(block->user), block->tag);
+
+      if (NextBlock(block)->prev != block)
+        fmt::fprintf(f, "ERROR: next block doesn't have proper back link\n");
+
+      if (block->tag == PU_FREE && NextBlock(block)->tag == PU_FREE)
+        fmt::fprintf(f, "ERROR: two consecutive free blocks\n");
+    }
+  }
+}
+
+//
+// Z_CheckHeap
+//
+void Z_CheckHeap() {
+  int free_blocks = 0;
+
+  for (memzone_t * zone = zones; zone != nullptr; zone = zone->next) {
+    for (memblock_t * block = NextBlock(FirstBlock(zone));; block = NextBlock(block)) {
+      if (block->id == ZONECAP) {
+        // the end cap, all blocks have been hit
+        break;
+      }
+
+      if (block->size < static_cast<int>(sizeof(memblock_t)) || reinterpret_cast<uint8_t *>(NextBlock(block)) > reinterpret_cast<uint8_t *>(zone) + zone->size)
+        I_Error("Z_CheckHeap: block size does not touch the next block\n");
+
+      if (NextBlock(block)->prev != block)
+        I_Error("Z_CheckHeap: next block doesn't have proper back link\n");
+
+      if (block->tag == PU_FREE && NextBlock(block)->tag == PU_FREE)
+        I_Error("Z_CheckHeap: two consecutive free blocks\n");
+
+      if (block->tag == PU_FREE)
+        free_blocks++;
+      else if (block->id != ZONEID)
+        I_Error("Z_CheckHeap: block without a ZONEID\n");
+    }
+  }
+
+  // every free block must be in the list of its size class
+  for (int i = 0; i < NUMSIZECLASSES; ++i) {
+    for (memblock_t * block = free_lists[i].list_next; block != &free_lists[i]; block = block->list_next) {
+      if (block->tag != PU_FREE || SizeClass(block->size) != i)
+        I_Error("Z_CheckHeap: block in the wrong free list\n");
+
+      free_blocks--;
+    }
+
+    if ((free_lists[i].list_next != &free_lists[i]) != ((free_classes >> i) & 1))
+      I_Error("Z_CheckHeap: size class bitmap out of date\n");
+  }
+
+  if (free_blocks != 0)
+    I_Error("Z_CheckHeap: free block lists do not match the heap\n");
+
+  for (int i = 0; i < PU_NUM_TAGS; ++i) {
+    for (memblock_t * block = tag_chains[i].list_next; block != &tag_chains[i]; block = block->list_next) {
+      if (block->tag != i || block->list_next->list_prev != block)
+        I_Error("Z_CheckHeap: tag chain corrupted!\n");
+    }
+  }
+}
+
+//
+// Z_ChangeTag
+//
+void Z_ChangeTag2(void * ptr, int tag, cstring_view file, int line) {
+  memblock_t * block = DataBlock(ptr);
+
+  if (block->id != ZONEID)
+    I_Error("%s:%i: Z_ChangeTag: block without a ZONEID!",
+            file.c_str(),
+            line);
+
+  if (tag >= PU_PURGELEVEL && block->user == nullptr)
+    I_Error("%s:%i: Z_ChangeTag: an owner is required "
+            "for purgable blocks",
+            file.c_str(),
+            line);
+
+  // Move the block to the head of its new chain, which also
+  // marks it as the most recently used.
+
+  ListRemove(block);
+  block->tag = tag;
+  ListInsert(&tag_chains[tag], block);
+}
+
+[[maybe_unused]] void Z_ChangeUser(void * ptr, void ** user) {
+  memblock_t * block = DataBlock(ptr);
+
+  if (block->id != ZONEID) {
+    I_Error("Z_ChangeUser: Tried to change user for invalid block!");
+  }
+
+  block->user = user;
+  *user       = ptr;
+}
+
+//
+// Z_FreeMemory
+//
+[[maybe_unused]] int Z_FreeMemory() {
+  int free = 0;
+
+  for (auto & list : free_lists) {
+    for (memblock_t * block = list.list_next; block != &list; block = block->list_next) {
+      free += block->size;
+    }
+  }
+
+  for (int tag = PU_PURGELEVEL; tag < PU_NUM_TAGS; ++tag) {
+    for (memblock_t * block = tag_chains[tag].list_next; block != &tag_chains[tag]; block = block->list_next) {
+      free += block->size;
+    }
+  }
+
+  return free;
+}
+
+[[maybe_unused]] unsigned int Z_ZoneSize() {
+  unsigned int size = 0;
+
+  for (memzone_t * zone = zones; zone != nullptr; zone = zone->next) {
+    size += static_cast<unsigned int>(zone->size);
+  }
+
+  return size;
+}
+
+//
+// Z_GetStats
+//
+void Z_GetStats(zone_stats_t * stats) {
+  *stats        = {};
+  stats->purges = zone_purges;
+  stats->grows  = zone_grows;
+
+  for (memzone_t * zone = zones; zone != nullptr; zone = zone->next) {
+    stats->zone_bytes += static_cast<size_t>(zone->size);
+  }
+
+  for (auto & list : free_lists) {
+    for (memblock_t * block = list.list_next; block != &list; block = block->list_next) {
+      const auto size = static_cast<size_t>(block->size);
+
+      stats->free_bytes += size;
+      stats->free_blocks++;
+
+      if (size > stats->largest_free)
+        stats->largest_free = size;
+    }
+  }
+
+  for (int tag = 0; tag < PU_NUM_TAGS; ++tag) {
+    for (memblock_t * block = tag_chains[tag].list_next; block != &tag_chains[tag]; block = block->list_next) {
+      stats->tag_bytes[tag] += static_cast<size_t>(block->size);
+      stats->tag_blocks[tag]++;
+    }
+  }
+}
@@ -63,6 +63,10 @@ static memzone_t * mainzone;
 static bool        zero_on_free;
 static bool        scan_on_free;
 
+// [crispy] for Z_GetStats()
+static int zone_purges;
+static int zone_grows;
+
 //
 // Z_ClearZone
 //
@@ -248,6 +252,7 @@ void *
 
       // [crispy] allocate another zone twice as big
       Z_Init();
+      zone_grows++;
 
       base  = mainzone->rover;
       rover = base;
@@ -265,6 +270,7 @@ void *
         // the rover can be the base block
         base = base->prev;
         Z_Free(reinterpret_cast<uint8_t *>(rover) + sizeof(memblock_t));
+        zone_purges++;
         base  = base->next;
         rover = base->next;
       }
@@ -468,3 +474,32 @@ void Z_ChangeTag2(void * ptr, int tag, cstring_view file, int line) {
 [[maybe_unused]] unsigned int Z_ZoneSize() {
   return static_cast<unsigned int>(mainzone->size);
 }
+
+//
+// Z_GetStats
+// [crispy] Only the current zone is counted, the ones that
+// were full when it was allocated are no longer tracked.
+//
+void Z_GetStats(zone_stats_t * stats) {
+  *stats            = {};
+  stats->zone_bytes = static_cast<size_t>(mainzone->size);
+  stats->purges     = zone_purges;
+  stats->grows      = zone_grows;
+
+  for (memblock_t * block = mainzone->blocklist.next;
+       block != &mainzone->blocklist;
+       block = block->next) {
+    const auto size = static_cast<size_t>(block->size);
+
+    if (block->tag == PU_FREE) {
+      stats->free_bytes += size;
+      stats->free_blocks++;
+
+      if (size > stats->largest_free)
+        stats->largest_free = size;
+    } else {
+      stats->tag_bytes[block->tag] += size;
+      stats->tag_blocks[block->tag]++;
+    }
+  }
+}
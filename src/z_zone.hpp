@@ -21,6 +21,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdio>
 
 #include "cstring_view.hpp"
@@ -60,6 +61,25 @@ void                          Z_ChangeTag2(void * ptr, int tag, cstring_view fil
 [[maybe_unused]] int          Z_FreeMemory();
 [[maybe_unused]] unsigned int Z_ZoneSize();
 
+// [crispy] Live zone heap statistics. Sizes include the block headers.
+struct zone_stats_t {
+  size_t tag_bytes[PU_NUM_TAGS];  // allocated, by tag
+  int    tag_blocks[PU_NUM_TAGS]; // allocated blocks, by tag
+  size_t zone_bytes;              // all zones, 0 for z_native.cpp
+  size_t free_bytes;
+  size_t largest_free;
+  int    free_blocks;
+  int    purges; // purgable blocks freed to make room
+  int    grows;  // zones added because the heap was full
+};
+
+void Z_GetStats(zone_stats_t * stats);
+
+// Share of the free memory that is not in the largest free block.
+inline double Z_Fragmentation(const zone_stats_t & stats) {
+  return stats.free_bytes > 0 ? 1.0 - static_cast<double>(stats.largest_free) / static_cast<double>(stats.free_bytes) : 0.0;
+}
+
 //
 // This is used to get the local FILE:LINE info from CPP
 // prior to really call the function in question.
@@ -0,0 +1,151 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Playsim benchmark driver.
+//
+//	The engine is set up the way D_DoomMain() does for -nographics
+//	-nosound, except that no configuration file is read: every
+//	setting that affects the measured code is pinned here, so that
+//	results can be compared across commits and machines.
+//
+
+#include <string>
+#include <vector>
+
+#include <catch2/catch_session.hpp>
+#include <fmt/format.h>
+#include <fmt/printf.h>
+
+#include "bench_playsim.hpp"
+
+#include "crispy.hpp"
+#include "d_loop.hpp"
+#include "doomstat.hpp"
+#include "g_game.hpp"
+#include "hu_stuff.hpp"
+#include "i_video.hpp"
+#include "m_argv.hpp"
+#include "m_menu.hpp"
+#include "p_local.hpp"
+#include "p_setup.hpp"
+#include "p_tick.hpp"
+#include "r_main.hpp"
+#include "s_sound.hpp"
+#include "st_stuff.hpp"
+#include "v_video.hpp"
+#include "w_wad.hpp"
+#include "z_zone.hpp"
+
+void D_IdentifyVersion();
+void R_ExecuteSetViewSize();
+
+static std::vector<bench_map_t> maps;
+
+bool BenchInit(const char * iwad) {
+  // renderer settings: crispy default resolution, no widescreen
+  // or uncapped interpolation, full screen view
+  crispy->hires      = 1;
+  crispy->widescreen = 0;
+  crispy->uncapped   = 0;
+  screenblocks       = 11;
+  detailLevel        = 0;
+
+  Z_Init();
+
+  if (W_AddFile(iwad) == nullptr) {
+    return false;
+  }
+
+  W_GenerateHashTable();
+  D_IdentifyVersion();
+
+  g_doomstat_globals->gameversion = g_doomstat_globals->gamemode == retail ? exe_ultimate : exe_doom_1_9;
+
+  // draw into a plain memory buffer instead of an SDL surface
+  static std::vector<pixel_t> screen(MAXWIDTH * MAXHEIGHT);
+
+  I_GetScreenDimensions();
+  g_i_video_globals->I_VideoBuffer = screen.data();
+  V_Init();
+  V_RestoreBuffer();
+
+  R_Init();
+  P_Init();
+  S_Init(0, 0);
+  HU_Init();
+  ST_Init();
+
+  R_ExecuteSetViewSize();
+
+  // the playsim runs one tic per call, without network updates
+  singletics                          = true;
+  g_doomstat_globals->playeringame[0] = true;
+  g_doomstat_globals->consoleplayer   = 0;
+  g_doomstat_globals->displayplayer   = 0;
+
+  if (g_doomstat_globals->gamemode == commercial) {
+    for (int map = 1; map <= 32; map++) {
+      if (P_GetNumForMap(1, map, false) >= 0) {
+        maps.push_back({ 1, map, fmt::format("MAP{:02d}", map) });
+      }
+    }
+  } else {
+    for (int episode = 1; episode <= 4; episode++) {
+      for (int map = 1; map <= 9; map++) {
+        if (P_GetNumForMap(episode, map, false) >= 0) {
+          maps.push_back({ episode, map, fmt::format("E{}M{}", episode, map) });
+        }
+      }
+    }
+  }
+
+  return true;
+}
+
+const std::vector<bench_map_t> & BenchMaps() {
+  return maps;
+}
+
+void BenchSetupLevel(const bench_map_t & map) {
+  // G_InitNew() clears the random number generator and sets the sky
+  // before calling P_SetupLevel()
+  G_InitNew(sk_hard, map.episode, map.map);
+
+  // one tic to settle the player's view height
+  P_Ticker();
+}
+
+int main(int argc, char * argv[]) {
+  using namespace Catch::Clara;
+
+  Catch::Session session;
+  std::string    iwad = "data/demos/DOOM.WAD";
+
+  session.cli(session.cli() | Opt(iwad, "iwad")["--iwad"]("IWAD to load the benchmark maps from"));
+
+  const int result = session.applyCommandLine(argc, argv);
+  if (result != 0) {
+    return result;
+  }
+
+  myargc = argc;
+  myargv = argv;
+
+  if (!BenchInit(iwad.c_str())) {
+    fmt::fprintf(stderr, "bench_cpp_doom: Couldn't open %s\n", iwad);
+    return 1;
+  }
+
+  return session.run();
+}
@@ -0,0 +1,140 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Playsim and renderer microbenchmarks, one per map.
+//
+//	P_Ticker is measured over the first ten seconds of game time
+//	after loading the map, with the player standing still.
+//	P_CheckSight and P_PathTraverse are measured from the player
+//	start to every shootable thing on the map, which is the pattern
+//	monster AI and hitscan attacks produce. R_RenderPlayerView is
+//	measured from the player start in eight directions.
+//
+
+#include <vector>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "bench_playsim.hpp"
+
+#include "doomstat.hpp"
+#include "i_timer.hpp"
+#include "p_local.hpp"
+#include "p_tick.hpp"
+#include "r_main.hpp"
+
+// game tics run by one P_Ticker sample
+constexpr auto BENCH_TICS = 10 * TICRATE;
+
+static mobj_t * BenchPlayer() {
+  return g_doomstat_globals->players[0].mo;
+}
+
+static std::vector<mobj_t *> BenchTargets() {
+  std::vector<mobj_t *> targets;
+
+  action_hook needle = P_MobjThinker;
+  for (thinker_t * th = g_p_local_globals->thinkercap.next; th != &g_p_local_globals->thinkercap; th = th->next) {
+    if (th->function != needle)
+      continue;
+
+    auto * mo = reinterpret_cast<mobj_t *>(th);
+
+    if ((mo->flags & MF_SHOOTABLE) && mo != BenchPlayer()) {
+      targets.push_back(mo);
+    }
+  }
+
+  return targets;
+}
+
+static bool PTR_BenchTraverse(intercept_t *) {
+  // keep going to the end of the line
+  return true;
+}
+
+TEST_CASE("P_SetupLevel", "[playsim]") {
+  for (const auto & map : BenchMaps()) {
+    BENCHMARK(map.name) {
+      BenchSetupLevel(map);
+    };
+  }
+}
+
+TEST_CASE("P_Ticker", "[playsim]") {
+  for (const auto & map : BenchMaps()) {
+    // every sample starts from the same freshly loaded level
+    BENCHMARK_ADVANCED(map.name)(Catch::Benchmark::Chronometer meter) {
+      BenchSetupLevel(map);
+      meter.measure([] {
+        for (int i = 0; i < BENCH_TICS; i++) {
+          P_Ticker();
+        }
+        return leveltime;
+      });
+    };
+  }
+}
+
+TEST_CASE("P_CheckSight", "[playsim]") {
+  for (const auto & map : BenchMaps()) {
+    BenchSetupLevel(map);
+
+    mobj_t * const              player  = BenchPlayer();
+    const std::vector<mobj_t *> targets = BenchTargets();
+
+    BENCHMARK(map.name) {
+      int visible = 0;
+      for (mobj_t * target : targets) {
+        visible += P_CheckSight(player, target);
+      }
+      return visible;
+    };
+  }
+}
+
+TEST_CASE("P_PathTraverse", "[playsim]") {
+  for (const auto & map : BenchMaps()) {
+    BenchSetupLevel(map);
+
+    mobj_t * const              player  = BenchPlayer();
+    const std::vector<mobj_t *> targets = BenchTargets();
+
+    BENCHMARK(map.name) {
+      int completed = 0;
+      for (mobj_t * target : targets) {
+        completed += P_PathTraverse(player->x, player->y, target->x, target->y, PT_ADDLINES | PT_ADDTHINGS, PTR_BenchTraverse);
+      }
+      return completed;
+    };
+  }
+}
+
+TEST_CASE("R_RenderPlayerView", "[render]") {
+  for (const auto & map : BenchMaps()) {
+    BenchSetupLevel(map);
+
+    player_t * const player = &g_doomstat_globals->players[0];
+    const angle_t    angle  = player->mo->angle;
+
+    BENCHMARK(map.name) {
+      for (int i = 0; i < 8; i++) {
+        player->mo->angle = angle + static_cast<angle_t>(i) * ANG45;
+        R_RenderPlayerView(player);
+      }
+      player->mo->angle = angle;
+    };
+  }
+}
@@ -0,0 +1,37 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Headless engine setup shared by the playsim benchmarks.
+//
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+struct bench_map_t {
+  int         episode;
+  int         map;
+  std::string name;
+};
+
+// Bring up the zone, WAD, renderer and playsim without a window or
+// sound device. Returns false if the IWAD could not be opened.
+bool BenchInit(const char * iwad);
+
+// Every map present in the loaded IWAD, in episode/map order.
+const std::vector<bench_map_t> & BenchMaps();
+
+// Start a fresh single player game on the given map at UV skill.
+void BenchSetupLevel(const bench_map_t & map);
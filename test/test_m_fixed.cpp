@@ -0,0 +1,162 @@
+#include <catch.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "m_fixed.hpp"
+
+// batch fixed point math must match the scalar functions bit for bit
+
+static const std::vector<fixed_t> edge_values = {
+  0,
+  1,
+  -1,
+  2,
+  -2,
+  FRACUNIT - 1,
+  FRACUNIT,
+  FRACUNIT + 1,
+  -FRACUNIT,
+  (1 << 14) - 1,
+  1 << 14,
+  -(1 << 14),
+  1 << 30,
+  -(1 << 30),
+  0x12345678,
+  -0x12345678,
+  std::numeric_limits<int32_t>::max() - 1,
+  std::numeric_limits<int32_t>::max(),
+  std::numeric_limits<int32_t>::min() + 1,
+  std::numeric_limits<int32_t>::min(),
+};
+
+// FixedDiv(INT_MIN, 0) divides by zero
+static bool valid_div(fixed_t a, fixed_t b) {
+  return b != 0 || a != std::numeric_limits<int32_t>::min();
+}
+
+static void check_mul(const std::vector<fixed_t> & a, const std::vector<fixed_t> & b) {
+  std::vector<fixed_t> out(a.size());
+
+  FixedMulBatch(out.data(), a.data(), b.data(), static_cast<int>(a.size()));
+  for (size_t i = 0; i < a.size(); i++) {
+    REQUIRE(out[i] == FixedMul(a[i], b[i]));
+  }
+}
+
+static void check_mul_scalar(const std::vector<fixed_t> & a, fixed_t b) {
+  std::vector<fixed_t> out(a.size());
+
+  FixedMulBatch(out.data(), a.data(), b, static_cast<int>(a.size()));
+  for (size_t i = 0; i < a.size(); i++) {
+    REQUIRE(out[i] == FixedMul(a[i], b));
+  }
+}
+
+static void check_div(const std::vector<fixed_t> & a, const std::vector<fixed_t> & b) {
+  std::vector<fixed_t> out(a.size());
+
+  FixedDivBatch(out.data(), a.data(), b.data(), static_cast<int>(a.size()));
+  for (size_t i = 0; i < a.size(); i++) {
+    REQUIRE(out[i] == FixedDiv(a[i], b[i]));
+  }
+}
+
+TEST_CASE("batch_edge_pairs", "[fixed]") {
+  std::vector<fixed_t> a, b;
+
+  for (fixed_t x : edge_values) {
+    for (fixed_t y : edge_values) {
+      if (valid_div(x, y)) {
+        a.push_back(x);
+        b.push_back(y);
+      }
+    }
+  }
+
+  check_mul(a, b);
+  check_div(a, b);
+
+  for (fixed_t y : edge_values) {
+    check_mul_scalar(edge_values, y);
+  }
+}
+
+TEST_CASE("batch_sweep", "[fixed]") {
+  // every 65521st value of the whole range against each edge value
+  std::vector<fixed_t> a;
+  for (int64_t x = std::numeric_limits<int32_t>::min(); x <= std::numeric_limits<int32_t>::max(); x += 65521) {
+    a.push_back(static_cast<fixed_t>(x));
+  }
+
+  for (fixed_t y : edge_values) {
+    std::vector<fixed_t> b(a.size(), y);
+    std::vector<fixed_t> a_div, b_div;
+
+    for (size_t i = 0; i < a.size(); i++) {
+      if (valid_div(a[i], y)) {
+        a_div.push_back(a[i]);
+        b_div.push_back(y);
+      }
+    }
+
+    check_mul(a, b);
+    check_mul(b, a);
+    check_mul_scalar(a, y);
+    check_div(a_div, b_div);
+
+    // and with the operands swapped
+    a_div.clear();
+    b_div.clear();
+    for (size_t i = 0; i < a.size(); i++) {
+      if (valid_div(y, a[i])) {
+        a_div.push_back(y);
+        b_div.push_back(a[i]);
+      }
+    }
+    check_div(a_div, b_div);
+  }
+}
+
+TEST_CASE("batch_random", "[fixed]") {
+  std::mt19937                           rng(1993);
+  std::uniform_int_distribution<int32_t> full;
+  std::uniform_int_distribution<int32_t> map_units(-32768 * FRACUNIT, 32767 * FRACUNIT);
+
+  std::vector<fixed_t> a(1 << 20), b(1 << 20);
+
+  for (size_t i = 0; i < a.size(); i++) {
+    a[i] = full(rng);
+    b[i] = full(rng);
+    if (!valid_div(a[i], b[i])) {
+      b[i] = 1;
+    }
+  }
+  check_mul(a, b);
+  check_div(a, b);
+
+  // values in the range the renderer and playsim actually use
+  for (size_t i = 0; i < a.size(); i++) {
+    a[i] = map_units(rng);
+    b[i] = map_units(rng) >> (i % 16);
+    if (!valid_div(a[i], b[i])) {
+      b[i] = 1;
+    }
+  }
+  check_mul(a, b);
+  check_div(a, b);
+}
+
+TEST_CASE("batch_lengths", "[fixed]") {
+  // vector bodies and scalar tails of every length
+  for (size_t count = 0; count <= 9; count++) {
+    std::vector<fixed_t> a(edge_values.begin(), edge_values.begin() + static_cast<std::ptrdiff_t>(count));
+    std::vector<fixed_t> b(edge_values.rbegin(), edge_values.rbegin() + static_cast<std::ptrdiff_t>(count));
+
+    check_mul(a, b);
+    check_mul_scalar(a, FRACUNIT / 3);
+    check_div(a, b);
+  }
+}
@@ -0,0 +1,138 @@
+#include <catch.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "r_angle.hpp"
+
+// R_PointToAngleBatchAt() must match R_PointToAngleCrispyAt() in every
+// lane, the renderer clips segs with these angles
+
+constexpr fixed_t int_min = std::numeric_limits<int32_t>::min();
+constexpr fixed_t int_max = std::numeric_limits<int32_t>::max();
+
+static const std::vector<fixed_t> edge_deltas = {
+  0,
+  1,
+  -1,
+  2,
+  -2,
+  255,
+  -255,
+  511,
+  -511,
+  512,
+  -512,
+  513,
+  FRACUNIT,
+  -FRACUNIT,
+  FRACUNIT + 1,
+  0x12345678,
+  -0x12345678,
+  1 << 30,
+  -(1 << 30),
+  int_max - 1,
+  int_max,
+  int_min + 1,
+  int_min,
+};
+
+// Compare the whole batch, and every shorter batch from the start,
+// so counts that are not a multiple of four go through the tail loop.
+
+static void check_batch(fixed_t viewx, fixed_t viewy, const std::vector<fixed_t> & x, const std::vector<fixed_t> & y) {
+  std::vector<angle_t> out(x.size());
+
+  for (size_t count = 0; count <= x.size(); count++) {
+    if (count > 8 && count + 8 < x.size()) {
+      continue;
+    }
+
+    R_PointToAngleBatchAt(viewx, viewy, out.data(), x.data(), y.data(), static_cast<int>(count));
+
+    for (size_t i = 0; i < count; i++) {
+      INFO("view " << viewx << "," << viewy << " point " << x[i] << "," << y[i] << " count " << count);
+      REQUIRE(out[i] == R_PointToAngleCrispyAt(viewx, viewy, x[i], y[i]));
+    }
+  }
+}
+
+TEST_CASE("angle_batch_edge_deltas", "[angle]") {
+  // all eight octants, x == y, zero deltas and den < 512
+  std::vector<fixed_t> x, y;
+
+  for (fixed_t dx : edge_deltas) {
+    for (fixed_t dy : edge_deltas) {
+      x.push_back(dx);
+      y.push_back(dy);
+    }
+  }
+
+  check_batch(0, 0, x, y);
+}
+
+TEST_CASE("angle_batch_diagonals", "[angle]") {
+  std::vector<fixed_t> x, y;
+
+  // wrapping, the deltas go up to INT_MIN and INT_MAX
+  auto add = [](fixed_t a, int b) { return static_cast<fixed_t>(static_cast<uint32_t>(a) + static_cast<uint32_t>(b)); };
+  auto neg = [](fixed_t a) { return static_cast<fixed_t>(0u - static_cast<uint32_t>(a)); };
+
+  for (fixed_t d : edge_deltas) {
+    x.insert(x.end(), { d, d, neg(d), neg(d), d, add(d, 1), add(d, -1) });
+    y.insert(y.end(), { d, neg(d), d, neg(d), add(d, -1), d, d });
+  }
+
+  check_batch(0, 0, x, y);
+}
+
+TEST_CASE("angle_batch_small_den", "[angle]") {
+  // SlopeDivCrispy() returns SLOPERANGE for den < 512
+  std::vector<fixed_t> x, y;
+
+  for (fixed_t a = -600; a <= 600; a += 7) {
+    for (fixed_t b = -600; b <= 600; b += 13) {
+      x.push_back(a);
+      y.push_back(b);
+    }
+  }
+
+  check_batch(0, 0, x, y);
+}
+
+TEST_CASE("angle_batch_overflowing_deltas", "[angle]") {
+  // deltas outside of the int32_t range are halved
+  std::vector<fixed_t> x, y;
+
+  for (fixed_t a : edge_deltas) {
+    for (fixed_t b : edge_deltas) {
+      x.push_back(a);
+      y.push_back(b);
+    }
+  }
+
+  for (fixed_t viewx : { int_min, int_max, -FRACUNIT, 0x40000000 }) {
+    for (fixed_t viewy : { int_min, int_max, FRACUNIT, -0x40000000 }) {
+      check_batch(viewx, viewy, x, y);
+    }
+  }
+}
+
+TEST_CASE("angle_batch_random", "[angle]") {
+  std::mt19937                           rng(1234);
+  std::uniform_int_distribution<int32_t> any(int_min, int_max);
+  std::uniform_int_distribution<int32_t> map(-32768 * FRACUNIT + 1, 32767 * FRACUNIT);
+
+  for (int run = 0; run < 64; run++) {
+    std::vector<fixed_t> x, y;
+
+    for (int i = 0; i < 1003; i++) {
+      x.push_back(run % 2 ? any(rng) : map(rng));
+      y.push_back(run % 2 ? any(rng) : map(rng));
+    }
+
+    check_batch(map(rng), map(rng), x, y);
+  }
+}
@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <catch.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "sha1.hpp"
+
+// sha1.cpp is linked into the test executable, it is not part of
+// lib_common_cpp_doom. The known digests are checked with each block
+// transform the CPU supports; SHA-NI is skipped where it is missing.
+
+static const sha1_transform_t transforms[] = { sha1_transform_t::portable, sha1_transform_t::shani };
+
+static const char * transform_name(sha1_transform_t transform) {
+  return transform == sha1_transform_t::shani ? "shani" : "portable";
+}
+
+// Selects a transform for the scope, and restores the default after
+struct transform_scope_t {
+  sha1_transform_t saved = SHA1_GetTransform();
+
+  explicit transform_scope_t(sha1_transform_t transform) { SHA1_SetTransform(transform); }
+  ~transform_scope_t() { SHA1_SetTransform(saved); }
+};
+
+static std::string digest_string(const uint8_t * data, size_t len) {
+  sha1_context_t context;
+  sha1_digest_t  digest;
+
+  SHA1_Init(&context);
+  SHA1_Update(&context, const_cast<uint8_t *>(data), len);
+  SHA1_Final(digest, &context);
+
+  std::string result;
+  for (uint8_t byte : digest) {
+    char hex[3];
+    snprintf(hex, sizeof(hex), "%02x", byte);
+    result += hex;
+  }
+
+  return result;
+}
+
+static std::string digest_string(const std::string & text) {
+  return digest_string(reinterpret_cast<const uint8_t *>(text.data()), text.size());
+}
+
+TEST_CASE("sha1_vectors", "[sha1]") {
+  for (sha1_transform_t transform : transforms) {
+    if (!SHA1_TransformSupported(transform)) {
+      WARN("skipping the " << transform_name(transform) << " transform, the CPU doesn't support it");
+      continue;
+    }
+
+    INFO("transform " << transform_name(transform));
+    transform_scope_t scope(transform);
+
+    REQUIRE(digest_string("") == "da39a3ee5e6b4b0d3255bfef95601890afd80709");
+    REQUIRE(digest_string("abc") == "a9993e364706816aba3e25717850c26c9cd0d89d");
+    REQUIRE(digest_string("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq") == "84983e441c3bd26ebaae4aa1f95129e5e54670f1");
+    REQUIRE(digest_string(std::string(1000000, 'a')) == "34aa973cd4c4daa4f61eeb2bdbad27316534016f");
+  }
+}
+
+static std::vector<uint8_t> pattern(size_t len) {
+  std::vector<uint8_t> data(len);
+  for (size_t i = 0; i < len; i++) {
+    data[i] = static_cast<uint8_t>(i * 131 + (i >> 7));
+  }
+  return data;
+}
+
+TEST_CASE("sha1_padding", "[sha1]") {
+  // the lengths around where the length needs an extra block
+  const std::vector<uint8_t> data = pattern(5000);
+
+  for (sha1_transform_t transform : transforms) {
+    if (!SHA1_TransformSupported(transform)) {
+      continue;
+    }
+
+    INFO("transform " << transform_name(transform));
+    transform_scope_t scope(transform);
+
+    REQUIRE(digest_string(data.data(), 55) == "336243d03df910f7914a14b13dd85f56c140660c");
+    REQUIRE(digest_string(data.data(), 56) == "f5cc93d5593579203ae8f3fc497baabf4fdfb417");
+    REQUIRE(digest_string(data.data(), 63) == "dba1c0f21c62eea4b5d19857487ded0db6095343");
+    REQUIRE(digest_string(data.data(), 64) == "4360095a2eea45a13a83190aeb049821aee57f46");
+    REQUIRE(digest_string(data.data(), 65) == "c0cfbc1b7f847964bf5e51ded17c7d0e2c0f4555");
+    REQUIRE(digest_string(data.data(), 119) == "99d71c308a6c094af624067e6db56482f887356f");
+    REQUIRE(digest_string(data.data(), 120) == "7b28fac5d8b376e2adc48146a698aea886e48f83");
+    REQUIRE(digest_string(data.data(), 5000) == "1c0bf5c9308c37cef5365fd26f736d20d80f8628");
+  }
+}
+
+TEST_CASE("sha1_transforms_agree", "[sha1]") {
+  if (!SHA1_TransformSupported(sha1_transform_t::shani)) {
+    WARN("skipping, the CPU doesn't support the SHA extensions");
+    return;
+  }
+
+  // every length up to a few blocks, then some larger ones
+  const std::vector<uint8_t> data = pattern(70000);
+
+  for (size_t len = 0; len < data.size(); len += len < 300 ? 1 : 997) {
+    std::string portable, shani;
+
+    {
+      transform_scope_t scope(sha1_transform_t::portable);
+      portable = digest_string(data.data(), len);
+    }
+
+    {
+      transform_scope_t scope(sha1_transform_t::shani);
+      shani = digest_string(data.data(), len);
+    }
+
+    INFO("length " << len);
+    REQUIRE(portable == shani);
+  }
+}
+
+TEST_CASE("sha1_split_updates", "[sha1]") {
+  // feeding the same data in pieces of any size gives the same digest
+  std::vector<uint8_t> data = pattern(5000);
+
+  for (size_t piece : { 1, 3, 63, 64, 65, 127, 200, 4096 }) {
+    sha1_context_t context;
+    sha1_digest_t  digest, expected;
+
+    SHA1_Init(&context);
+    for (size_t offset = 0; offset < data.size(); offset += piece) {
+      SHA1_Update(&context, data.data() + offset, std::min(piece, data.size() - offset));
+    }
+    SHA1_Final(digest, &context);
+
+    SHA1_Init(&context);
+    SHA1_Update(&context, data.data(), data.size());
+    SHA1_Final(expected, &context);
+
+    REQUIRE(std::memcmp(digest, expected, sizeof(digest)) == 0);
+  }
+}
@@ -0,0 +1,145 @@
+#include <catch.hpp>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "z_zone.hpp"
+
+// z_segregated.cpp is linked into the test executable in place of
+// the z_native.cpp from lib_common_cpp_doom
+
+static void zone_init() {
+  static bool initialized = false;
+
+  if (!initialized) {
+    Z_Init();
+    initialized = true;
+  }
+}
+
+TEST_CASE("zone_alloc_free", "[zone]") {
+  zone_init();
+
+  std::vector<uint8_t *> blocks;
+
+  for (int i = 0; i < 1000; i++) {
+    auto * block = static_cast<uint8_t *>(Z_Malloc(1 + (i * 37) % 5000, PU_STATIC, nullptr));
+    REQUIRE(reinterpret_cast<uintptr_t>(block) % sizeof(void *) == 0);
+    std::memset(block, i & 0xff, static_cast<size_t>(1 + (i * 37) % 5000));
+    blocks.push_back(block);
+  }
+
+  Z_CheckHeap();
+
+  // free every other block, then the rest
+  for (size_t i = 0; i < blocks.size(); i += 2) {
+    REQUIRE(blocks[i][0] == (i & 0xff));
+    Z_Free(blocks[i]);
+  }
+
+  Z_CheckHeap();
+
+  for (size_t i = 1; i < blocks.size(); i += 2) {
+    REQUIRE(blocks[i][(i * 37) % 5000] == (i & 0xff));
+    Z_Free(blocks[i]);
+  }
+
+  Z_CheckHeap();
+}
+
+TEST_CASE("zone_free_tags", "[zone]") {
+  zone_init();
+
+  void * level[100];
+  void * cache[100];
+  void * keep = Z_Malloc(100, PU_STATIC, nullptr);
+
+  for (int i = 0; i < 100; i++) {
+    Z_Malloc(64 + i, i % 2 ? PU_LEVEL : PU_LEVSPEC, &level[i]);
+    Z_Malloc(64 + i, PU_CACHE, &cache[i]);
+  }
+
+  Z_FreeTags(PU_LEVEL, PU_PURGELEVEL - 1);
+  Z_CheckHeap();
+
+  for (int i = 0; i < 100; i++) {
+    REQUIRE(level[i] == nullptr);
+    REQUIRE(cache[i] != nullptr);
+  }
+
+  Z_FreeTags(PU_PURGELEVEL, PU_CACHE);
+  Z_CheckHeap();
+
+  for (int i = 0; i < 100; i++) {
+    REQUIRE(cache[i] == nullptr);
+  }
+
+  Z_Free(keep);
+  Z_CheckHeap();
+}
+
+TEST_CASE("zone_purge_lru", "[zone]") {
+  zone_init();
+
+  const unsigned int zone_size = Z_ZoneSize();
+  const int          size      = 256 * 1024;
+  const int          count     = static_cast<int>(zone_size / size) * 2;
+
+  std::vector<void *> cache(static_cast<size_t>(count), nullptr);
+
+  // twice the zone in cached blocks, touching the first one
+  // every time so that it stays the most recently used
+  for (int i = 0; i < count; i++) {
+    Z_Malloc(size, PU_CACHE, &cache[static_cast<size_t>(i)]);
+
+    if (cache[0] != nullptr) {
+      Z_ChangeTag(cache[0], PU_CACHE);
+    }
+  }
+
+  Z_CheckHeap();
+
+  // purging made room, no zone was added
+  REQUIRE(Z_ZoneSize() == zone_size);
+
+  REQUIRE(cache[0] != nullptr);
+  REQUIRE(cache[1] == nullptr);
+  REQUIRE(cache[static_cast<size_t>(count - 1)] != nullptr);
+
+  Z_FreeTags(PU_PURGELEVEL, PU_CACHE);
+  Z_CheckHeap();
+}
+
+TEST_CASE("zone_stats", "[zone]") {
+  zone_init();
+
+  zone_stats_t before, after;
+  Z_GetStats(&before);
+
+  void * level[10];
+  for (auto & block : level) {
+    Z_Malloc(1000, PU_LEVEL, &block);
+  }
+
+  Z_GetStats(&after);
+
+  REQUIRE(after.tag_blocks[PU_LEVEL] == before.tag_blocks[PU_LEVEL] + 10);
+  REQUIRE(after.tag_bytes[PU_LEVEL] >= before.tag_bytes[PU_LEVEL] + 10 * 1000);
+  REQUIRE(after.largest_free <= after.free_bytes);
+  REQUIRE(Z_Fragmentation(after) >= 0.0);
+  REQUIRE(Z_Fragmentation(after) < 1.0);
+
+  // everything but the zone headers is accounted for
+  size_t used = after.free_bytes;
+  for (size_t bytes : after.tag_bytes) {
+    used += bytes;
+  }
+  REQUIRE(used <= after.zone_bytes);
+  REQUIRE(after.zone_bytes - used < 256);
+
+  Z_FreeTags(PU_LEVEL, PU_LEVEL);
+  Z_GetStats(&after);
+
+  REQUIRE(after.tag_blocks[PU_LEVEL] == before.tag_blocks[PU_LEVEL]);
+  REQUIRE(after.free_bytes == before.free_bytes);
+}
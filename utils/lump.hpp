@@ -15,3 +15,14 @@ template <typename DataType>
 auto cache_lump_num(lumpindex_t index, const int tag) {
   return static_cast<DataType>(W_CacheLumpNum(index, tag));
 }
+
+// read-only, DataType must be a pointer to const
+template <typename DataType>
+auto view_lump_name(cstring_view name, const int tag) {
+  return reinterpret_cast<DataType>(W_LumpViewName(name, tag).data);
+}
+
+template <typename DataType>
+auto view_lump_num(lumpindex_t index, const int tag) {
+  return reinterpret_cast<DataType>(W_LumpView(index, tag).data);
+}